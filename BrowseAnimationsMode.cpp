@@ -26,11 +26,13 @@
 #include "Types.h"
 #include "Codes.h"
 #include "Colors.h"
+#include "GifDecoder.h"
 
 #define ANIMATION_DISPLAY_DURATION_SECONDS 10
 
 // Defined in GIFParseFunctions.cpp
-extern unsigned long processGIFFile(const char *pathname, unsigned long(*checkForInput)());
+extern unsigned long processGIFFile(const char *pathname, unsigned long(*checkForInput)(), unsigned long playTime);
+extern boolean showGIFPreview(const char *pathname);
 
 // Defined in LightAppliance.ino
 extern unsigned long checkForInput();
@@ -40,10 +42,19 @@ void BrowseAnimationsMode::run(SmartMatrix matrix, IRrecv irReceiver, SdFat sd)
     BrowseAnimationsMode::irReceiver = &irReceiver;
     BrowseAnimationsMode::sd = &sd;
 
-    browseDirectory("/");
+    BrowseListing browseListings[BROWSE_CACHE_DIRECTORIES];
+    memset(browseListings, 0, sizeof(browseListings));
+    listings = browseListings;
+    listingClock = 0;
+
+    browseDirectory("/", 0);
+
+    listings = NULL;
 }
 
-void BrowseAnimationsMode::browseDirectory(const char *path) {
+// Browse the entries of a directory
+//   depth the number of directory levels above it
+void BrowseAnimationsMode::browseDirectory(const char *path, int depth) {
     int index = 0;
 
     Serial.print("browsing directory: ");
@@ -54,20 +65,12 @@ void BrowseAnimationsMode::browseDirectory(const char *path) {
     Serial.print("number of files: ");
     Serial.println(numberOfFiles);
 
-    while (true) {
-        // Clear screen
-        matrix->fillScreen(COLOR_BLACK);
-
-        // Fonts are font3x5, font5x7, font6x10, font8x13
-        matrix->setFont(font5x7);
-
-        // Static Mode Selection Text
-        matrix->drawString(2, 0, COLOR_BLUE, "Select");
+    if (numberOfFiles == 0) {
+        return;
+    }
 
-        matrix->setFont(font3x5);
-        matrix->drawString(3, 7, COLOR_BLUE, "Pattern");
-        matrix->drawString(3, 14, COLOR_BLUE, "< use >");
-        matrix->swapBuffers();
+    while (true) {
+        drawSelectionText();
 
         // Setup for scrolling mode
         matrix->setScrollMode(wrapForward);
@@ -78,29 +81,24 @@ void BrowseAnimationsMode::browseDirectory(const char *path) {
         matrix->scrollText("", 1);
 
         boolean fileSelected = false;
+        boolean previewShown = false;
 
         while (!fileSelected) {
             // Get current directory or file name
-            Serial.print("getting file name by index: ");
-            Serial.println(index);
-
             char name[13];
-            getNameByIndex(path, index, name, numberOfFiles);
-
-            Serial.print("name: ");
-            Serial.println(name);
+            boolean isDir;
+            const char *longName = getNameByIndex(path, index, name, &isDir);
 
-            if (strcmp(name, "SYSTEM~1") == 0 || (name[0] == '_') || name[0] == '~') {
-                index++;
-                break;
-            }
-
-            char selectedPath[255];
+            char selectedPath[BROWSE_PATH_SIZE + 13];
             strcpy(selectedPath, path);
             strcat(selectedPath, name);
-            strcat(selectedPath, "/");
 
-            char* longName = getDirectoryLongName(selectedPath);
+            // Take down the preview of the previous entry
+            if (previewShown) {
+                drawSelectionText();
+                previewShown = false;
+            }
+
             if (strcmp(longName, "") == 0) {
                 // Set name selection text
                 matrix->scrollText(name, 32000);
@@ -110,7 +108,20 @@ void BrowseAnimationsMode::browseDirectory(const char *path) {
                 matrix->scrollText(longName, 32000);
             }
 
-            unsigned long irCode = waitForIRCode();
+            // Show a frame of an animation as a preview of it once the
+            // selection has stayed on it for a while. Scrolling past entries
+            // reads nothing from the SD card, and the index a preview needs is
+            // only built for files the user stops at
+            unsigned long irCode = 0;
+            if (! isDir) {
+                irCode = waitForIRCode(BROWSE_PREVIEW_DELAY);
+                if ((irCode == 0) && showGIFPreview(selectedPath)) {
+                    previewShown = true;
+                }
+            }
+            if (irCode == 0) {
+                irCode = waitForIRCode();
+            }
             switch (irCode) {
                 case IRCODE_HOME:
                     return;
@@ -142,19 +153,19 @@ void BrowseAnimationsMode::browseDirectory(const char *path) {
                     Serial.print("selected file: ");
                     Serial.println(name);
 
-                    Serial.print("opening selected path: ");
-                    Serial.println(selectedPath);
-
-                    SdFile file;
-
-                    if (file.open(selectedPath)) {
-                        if (file.isDir()) {
-                            browseDirectory(selectedPath);
+                    if (isDir) {
+                        // Every directory level entered takes stack, so the
+                        // depth and the length of the path are limited
+                        if ((depth + 1 < BROWSE_MAX_DEPTH) && (strlen(selectedPath) + 1 < BROWSE_PATH_SIZE)) {
+                            strcat(selectedPath, "/");
+                            browseDirectory(selectedPath, depth + 1);
                         }
                         else {
-                            runAnimation(path, index, numberOfFiles);
+                            Serial.println("directory too deep to browse");
                         }
-                        file.close();
+                    }
+                    else {
+                        runAnimation(path, index, numberOfFiles);
                     }
                     fileSelected = true;
                     break;
@@ -163,31 +174,20 @@ void BrowseAnimationsMode::browseDirectory(const char *path) {
     }
 }
 
-char longNameChar[100];
-    
-char * BrowseAnimationsMode::getDirectoryLongName(const char *directoryName) {
-    char pathname[255];
-    strcpy(pathname, directoryName);
-    strcat(pathname, "index.txt");
-
-    String longName;
+void BrowseAnimationsMode::drawSelectionText() {
+    // Clear screen
+    matrix->fillScreen(COLOR_BLACK);
 
-    SdFile indexFile;
-    if (indexFile.open(pathname) && indexFile.isOpen() && indexFile.isFile()) {
-        int16_t c;
-        while ((c = indexFile.read()) > 0) {
-            char character = (char) c;
-            if (character == '\r' || character == 0) {
-                break;
-            }
+    // Fonts are font3x5, font5x7, font6x10, font8x13
+    matrix->setFont(font5x7);
 
-            longName.concat(character);
-        }
-    }
-    indexFile.close();
+    // Static Mode Selection Text
+    matrix->drawString(2, 0, COLOR_BLUE, "Select");
 
-    longName.toCharArray(longNameChar, 100);
-    return longNameChar;
+    matrix->setFont(font3x5);
+    matrix->drawString(3, 7, COLOR_BLUE, "Pattern");
+    matrix->drawString(3, 14, COLOR_BLUE, "< use >");
+    matrix->swapBuffers();
 }
 
 void BrowseAnimationsMode::runAnimation(const char* directoryName, int index, int numberOfFiles) {
@@ -195,6 +195,7 @@ void BrowseAnimationsMode::runAnimation(const char* directoryName, int index, in
     Serial.println(directoryName);
 
     bool timeoutDisabled = true;
+    int step = 1;
 
     while (true) {
         if (index < 0) {
@@ -204,29 +205,38 @@ void BrowseAnimationsMode::runAnimation(const char* directoryName, int index, in
             index = 0;
         }
 
+        char name[13];
+        boolean isDir;
+        getNameByIndex(directoryName, index, name, &isDir);
+
+        // Only files are played. Directories are passed over in the
+        // direction the user was moving
+        if (isDir) {
+            index += step;
+            continue;
+        }
+
         // Clear screen for new animation
         matrix->fillScreen(COLOR_BLACK);
         matrix->swapBuffers();
 
-        char name[13];
-        getNameByIndex(directoryName, index, name, numberOfFiles);
-
         char pathname[255];
         strcpy(pathname, directoryName);
         strcat(pathname, name);
 
-        // Calculate time in the future to terminate animation
-        unsigned long timeOut = millis() + (ANIMATION_DISPLAY_DURATION_SECONDS * 1000);
-
-        while (timeoutDisabled || timeOut > millis()) {
-            unsigned long result = processGIFFile(pathname, checkForInput);
+        step = 1;
+        while (true) {
+            // Play the animation for the display duration or until the user moves on
+            // DOWN skips ahead to the next key frame of the animation
+            unsigned long playTime = timeoutDisabled ? GIF_PLAY_FOREVER : (ANIMATION_DISPLAY_DURATION_SECONDS * 1000);
+            unsigned long result = processGIFFile(pathname, checkForInput, playTime);
 
             // handle user input
             if (result == IRCODE_HOME) {
                 return;
             }
             else if (result == IRCODE_LEFT) {
-                index -= 2;
+                step = -1;
                 break;
             }
             else if (result == IRCODE_RIGHT) {
@@ -236,99 +246,170 @@ void BrowseAnimationsMode::runAnimation(const char* directoryName, int index, in
                 // toggle timeout on/off
                 timeoutDisabled = !timeoutDisabled;
             }
-            else if (result != 0) {
+            else if ((result != 0) || (! timeoutDisabled)) {
                 break;
             }
         }
 
-        index++;
+        index += step;
     }
 }
 
-// count the number of directories and files
-int BrowseAnimationsMode::countFiles(const char* directoryName) {
-    int number = 0;
+// Get the listing of a directory from the cache, listing the directory
+// into the least recently used slot if it is not there
+BrowseListing *BrowseAnimationsMode::getListing(const char *directoryName) {
+    BrowseListing *listing = &listings[0];
 
-    // Set the current working directory
-    if (!sd->chdir(directoryName, true)) {
-        return 0;
+    for (int i = 0; i < BROWSE_CACHE_DIRECTORIES; i++) {
+        if (strcmp(listings[i].path, directoryName) == 0) {
+            listing = &listings[i];
+            listing->lastUsed = ++listingClock;
+            return listing;
+        }
+        if (listings[i].lastUsed < listing->lastUsed) {
+            listing = &listings[i];
+        }
     }
 
-    sd->vwd()->rewind();
+    buildListing(listing, directoryName);
+    listing->lastUsed = ++listingClock;
+    return listing;
+}
+
+// Directory entries that are browsed
+boolean BrowseAnimationsMode::isListed(const dir_t *entry) {
+    // Names starting with these chars and the Windows system directory are not listed
+    return (entry->name[0] != '_') && (entry->name[0] != '~') &&
+           (strncmp((const char *) entry->name, "SYSTEM~1   ", 11) != 0);
+}
 
-    SdFile file;
-    char fn[13];
-    while (file.openNext(sd->vwd(), O_READ)) {
-        file.getName(fn, 13);
-        // If filename not deleted, count it
-        if ((fn[0] != '_') && (fn[0] != '~')) {
-            number++;
-        }
+// List the entries of a directory and the long names of its subdirectories
+void BrowseAnimationsMode::buildListing(BrowseListing *listing, const char *directoryName) {
+    SdFile directory;
+    dir_t entry;
+    char name[13];
 
-        file.close();
+    listing->count = 0;
+    listing->longNamesSize = 0;
+
+    // A path too long to keep is listed every time it is asked for
+    if (strlen(directoryName) < BROWSE_PATH_SIZE) {
+        strcpy(listing->path, directoryName);
+    }
+    else {
+        listing->path[0] = '\0';
     }
 
-    // Set the current working directory
-    sd->chdir("/", true);
+    if (!directory.open(directoryName)) {
+        return;
+    }
 
-    return number;
+    while (directory.readDir(&entry) > 0) {
+        if (!isListed(&entry)) {
+            continue;
+        }
+        // Only the entries that fit are kept. The rest are found by reading
+        // the directory when they are shown
+        if (listing->count < BROWSE_CACHE_ENTRIES) {
+            BrowseEntry *browseEntry = &listing->entries[listing->count];
+            memcpy(browseEntry->name, entry.name, sizeof(browseEntry->name));
+            browseEntry->isDir = DIR_IS_SUBDIR(&entry);
+            browseEntry->longName = BROWSE_NO_LONG_NAME;
+
+            if (browseEntry->isDir) {
+                // Long names that don't fit are shown as the 8.3 name
+                SdBaseFile::dirName(entry, name);
+                readLongName(directoryName, name, longNameBuffer);
+                int len = strlen(longNameBuffer);
+                if ((len > 0) && (listing->longNamesSize + len + 1 <= BROWSE_CACHE_LONG_NAMES)) {
+                    browseEntry->longName = listing->longNamesSize;
+                    strcpy(listing->longNames + listing->longNamesSize, longNameBuffer);
+                    listing->longNamesSize += len + 1;
+                }
+            }
+        }
+        listing->count++;
+    }
+    directory.close();
 }
 
-// Get the full path/filename of the GIF file with specified index
-void BrowseAnimationsMode::getNameByIndex(const char *directoryName, int index, char *nameBuffer, int numberOfFiles) {
-    Serial.println("getNameByIndex");
-    char filename[13];
+// Read the long name of a subdirectory from the first line of its index.txt
+// longName is set to "" if it has none
+void BrowseAnimationsMode::readLongName(const char *directoryName, const char *name, char *longName) {
+    char pathname[255];
+    strcpy(pathname, directoryName);
+    strcat(pathname, name);
+    strcat(pathname, "/index.txt");
+
+    int len = 0;
 
-    // Make sure index is in range
-    Serial.println("Make sure index is in range");
-    if ((index >= 0) && (index < numberOfFiles)) {
-        Serial.println("index is in range");
-
-        // Set the current working directory
-        Serial.println("Set the current working directory");
-        if (!sd->chdir(directoryName, true)) {
-            Serial.println("Could not change to directory");
-            sd->errorHalt("Could not change to directory");
+    SdFile indexFile;
+    if (indexFile.open(pathname) && indexFile.isFile()) {
+        int16_t c;
+        while ((len < BROWSE_LONG_NAME_SIZE - 1) && ((c = indexFile.read()) > 0)) {
+            char character = (char) c;
+            if (character == '\r' || character == '\n') {
+                break;
+            }
+
+            longName[len++] = character;
         }
+    }
+    indexFile.close();
 
-        // Make sure file is closed before starting
-        SdFile file;
+    longName[len] = '\0';
+}
 
-        // Rewind the directory to the beginning
-        Serial.println("Rewind the directory to the beginning");
-        sd->vwd()->rewind();
+// count the number of directories and files
+int BrowseAnimationsMode::countFiles(const char* directoryName) {
+    return getListing(directoryName)->count;
+}
 
-        Serial.println("opening file");
-        while ((file.openNext(sd->vwd(), O_READ)) && (index >= 0)) {
-            Serial.println("getting filename");
-            file.getName(filename, 13);
+// Get the name of the directory or file with specified index
+// Returns its long name, or "" if it has none
+const char *BrowseAnimationsMode::getNameByIndex(const char *directoryName, int index, char *nameBuffer, boolean *isDir) {
+    BrowseListing *listing = getListing(directoryName);
+    dir_t entry;
 
-            Serial.print("filename: ");
-            Serial.println(filename);
+    nameBuffer[0] = '\0';
+    *isDir = false;
 
-            // If filename is not marked as deleted, count it
-            if ((filename[0] != '_') && (filename[0] != '~')) {
-                Serial.println("file is not marked as deleted");
-                index--;
-            }
-            Serial.println("closing file");
-            file.close();
+    // Make sure index is in range
+    if ((index < 0) || (index >= listing->count)) {
+        return "";
+    }
+
+    if (index < BROWSE_CACHE_ENTRIES) {
+        BrowseEntry *browseEntry = &listing->entries[index];
+        memcpy(entry.name, browseEntry->name, sizeof(entry.name));
+        SdBaseFile::dirName(entry, nameBuffer);
+        *isDir = browseEntry->isDir;
+
+        if (browseEntry->longName == BROWSE_NO_LONG_NAME) {
+            return "";
         }
+        return listing->longNames + browseEntry->longName;
+    }
 
-        // Set the current working directory back to root
-        Serial.println("Setting the current working directory back to root");
-        if (!sd->chdir("/", true)) {
-            Serial.println("Could not change to root directory");
-            sd->errorHalt("Could not change to root directory");
+    // Entries past those kept are found by reading the directory
+    SdFile directory;
+    if (!directory.open(directoryName)) {
+        return "";
+    }
+    while (directory.readDir(&entry) > 0) {
+        if (isListed(&entry) && (index-- == 0)) {
+            SdBaseFile::dirName(entry, nameBuffer);
+            *isDir = DIR_IS_SUBDIR(&entry);
+            break;
         }
+    }
+    directory.close();
 
-        // Copy the filename to the name buffer
-        Serial.println("Copying the filename to the name buffer");
-        strcpy(nameBuffer, filename);
-        Serial.println("Copied the filename to the name buffer");
-        Serial.print("name buffer:");
-        Serial.println(nameBuffer);
+    if (*isDir) {
+        readLongName(directoryName, nameBuffer, longNameBuffer);
+        return longNameBuffer;
     }
+    return "";
 }
 
 //// Check for input
@@ -352,6 +433,22 @@ unsigned long BrowseAnimationsMode::waitForIRCode() {
     return irCode;
 }
 
+// Wait up to timeout ms for an IR code
+// Function will return 0 if no IR code arrives in that time
+unsigned long BrowseAnimationsMode::waitForIRCode(unsigned long timeout) {
+
+    unsigned long start = millis();
+    unsigned long irCode = readIRCode();
+    while ((irCode == 0) || (irCode == 0xFFFFFFFF)) {
+        if (millis() - start >= timeout) {
+            return 0;
+        }
+        delay(20);
+        irCode = readIRCode();
+    }
+    return irCode;
+}
+
 // Read an IR code
 // Function will return 0 if no IR code available
 unsigned long BrowseAnimationsMode::readIRCode() {
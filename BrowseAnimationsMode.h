@@ -5,6 +5,46 @@
 #include "IRremote.h"
 #include "SdFat.h"
 
+// Directory listing cache
+// Every directory browsed is listed once, with the long names of its
+// subdirectories, so moving from entry to entry needs no SD card access.
+// The listings of the directory being browsed and the one browsed before it
+// are kept. They are on the stack of run(), so take no RAM outside the mode
+#define BROWSE_CACHE_DIRECTORIES 2
+#define BROWSE_CACHE_ENTRIES     64     // Entries kept of each directory
+#define BROWSE_CACHE_LONG_NAMES  192    // Bytes of long names kept of each directory
+#define BROWSE_PATH_SIZE         64
+#define BROWSE_LONG_NAME_SIZE    48     // Longest long name kept
+
+#define BROWSE_NO_LONG_NAME      0xFF
+
+// Directory levels that can be browsed, counting the root
+// run() takes about 2.3 KB of stack for the listings and every level entered
+// about 180 bytes more, so playing a file from the deepest level uses about
+// 4 KB of stack in all
+#define BROWSE_MAX_DEPTH         4
+
+// Time the selection has to stay on a file before its preview is shown in ms
+#define BROWSE_PREVIEW_DELAY     750
+
+typedef struct {
+    uint8_t name[11];           // 8.3 name as stored in the directory entry
+    boolean isDir;
+    uint8_t longName;           // Offset of the long name in longNames
+}
+BrowseEntry;
+
+typedef struct {
+    char path[BROWSE_PATH_SIZE];    // Empty if the listing is unused
+    unsigned long lastUsed;
+    int count;                      // Entries in the directory. Only the first
+                                    // BROWSE_CACHE_ENTRIES are kept
+    int longNamesSize;
+    BrowseEntry entries[BROWSE_CACHE_ENTRIES];
+    char longNames[BROWSE_CACHE_LONG_NAMES];
+}
+BrowseListing;
+
 class BrowseAnimationsMode{
 
 public:
@@ -15,18 +55,27 @@ private:
     IRrecv *irReceiver;
     SdFat *sd;
 
-    void browseDirectory(const char *path);
+    void browseDirectory(const char *path, int depth);
+    void drawSelectionText();
     void runAnimation(const char* directoryName, int index, int numberOfFiles);
 
-    char * getDirectoryLongName(const char *directoryName);
+    BrowseListing *listings;
+    unsigned long listingClock;
+    char longNameBuffer[BROWSE_LONG_NAME_SIZE];
+
+    BrowseListing *getListing(const char *directoryName);
+    void buildListing(BrowseListing *listing, const char *directoryName);
+    boolean isListed(const dir_t *entry);
+    void readLongName(const char *directoryName, const char *name, char *longName);
 
     int countFiles(const char *directoryName);
 
-    void getNameByIndex(const char *directoryName, int index, char *nameBuffer, int numberOfFiles);
+    const char *getNameByIndex(const char *directoryName, int index, char *nameBuffer, boolean *isDir);
 
     // unsigned long checkForInput();
 
     unsigned long waitForIRCode();
+    unsigned long waitForIRCode(unsigned long timeout);
     unsigned long readIRCode();
     unsigned long _readIRCode();
 };
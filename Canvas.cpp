@@ -0,0 +1,112 @@
+/*
+ * Direct drawing into the back buffer of the matrix
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "Canvas.h"
+
+// Fill consecutive pixels with a color
+void Canvas::fillPixels(rgb24 *dst, int count, rgb24 color) {
+
+    if (count <= 0) {
+        return;
+    }
+
+    // Greys, black and white included, have the same value in every byte
+    if ((color.red == color.green) && (color.green == color.blue)) {
+        memset(dst, color.red, count * sizeof(rgb24));
+        return;
+    }
+
+    // Otherwise keep doubling the pixels filled so far
+    dst[0] = color;
+    int filled = 1;
+    while (filled < count) {
+        int n = min(filled, count - filled);
+        memcpy(dst + filled, dst, n * sizeof(rgb24));
+        filled += n;
+    }
+}
+
+// Fill pixels x0 to x1 of a row
+void Canvas::fillSpan(int x0, int x1, int y, rgb24 color) {
+
+    if ((y < 0) || (y >= CANVAS_HEIGHT)) {
+        return;
+    }
+    x0 = max(x0, 0);
+    x1 = min(x1, CANVAS_WIDTH - 1);
+
+    fillPixels(row(y) + x0, x1 - x0 + 1, color);
+}
+
+// Copy count colors to a row starting at x
+void Canvas::blitRow(int x, int y, const rgb24 *colors, int count) {
+
+    if ((y < 0) || (y >= CANVAS_HEIGHT)) {
+        return;
+    }
+    if (x < 0) {
+        colors -= x;
+        count += x;
+        x = 0;
+    }
+    count = min(count, CANVAS_WIDTH - x);
+    if (count > 0) {
+        memcpy(row(y) + x, colors, count * sizeof(rgb24));
+    }
+}
+
+// Fill the rectangle with corners (x0, y0) and (x1, y1)
+void Canvas::fillRect(int x0, int y0, int x1, int y1, rgb24 color) {
+
+    x0 = max(x0, 0);
+    y0 = max(y0, 0);
+    x1 = min(x1, CANVAS_WIDTH - 1);
+    y1 = min(y1, CANVAS_HEIGHT - 1);
+
+    int width = x1 - x0 + 1;
+    if ((width <= 0) || (y0 > y1)) {
+        return;
+    }
+
+    // Rows that span the display are consecutive in the buffer
+    if (width == CANVAS_WIDTH) {
+        fillPixels(row(y0), width * (y1 - y0 + 1), color);
+        return;
+    }
+
+    // Fill the first row and copy it to the others
+    rgb24 *first = row(y0) + x0;
+    fillPixels(first, width, color);
+    for (int y = y0 + 1; y <= y1; y++) {
+        memcpy(row(y) + x0, first, width * sizeof(rgb24));
+    }
+}
+
+// Fill the whole display
+void Canvas::fill(rgb24 color) {
+
+    fillPixels(buffer, CANVAS_WIDTH * CANVAS_HEIGHT, color);
+}
@@ -0,0 +1,66 @@
+/*
+ * Direct drawing into the back buffer of the matrix
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef Canvas_H
+#define Canvas_H
+
+#include "SmartMatrix_32x32.h"
+
+#define CANVAS_WIDTH    MATRIX_WIDTH
+#define CANVAS_HEIGHT   MATRIX_HEIGHT
+
+// A canvas draws straight into the back buffer of the matrix without the
+// bounds check and rotation of drawPixel() for every pixel, like the GIF
+// decoder does. The matrix must not be rotated.
+// swapBuffers() changes the back buffer so make a new canvas after it.
+class Canvas {
+public:
+    Canvas(SmartMatrix &matrix) {
+        buffer = matrix.backBuffer();
+    }
+
+    // Pixels of a row, y must be on the display
+    rgb24 *row(int y) {
+        return buffer + (y * CANVAS_WIDTH);
+    }
+
+    // Set a pixel without checking it is on the display
+    void setPixel(int x, int y, rgb24 color) {
+        buffer[(y * CANVAS_WIDTH) + x] = color;
+    }
+
+    // These are clipped to the display
+    void fillSpan(int x0, int x1, int y, rgb24 color);
+    void blitRow(int x, int y, const rgb24 *colors, int count);
+    void fillRect(int x0, int y0, int x1, int y1, rgb24 color);
+    void fill(rgb24 color);
+
+private:
+    rgb24 *buffer;
+
+    static void fillPixels(rgb24 *dst, int count, rgb24 color);
+};
+
+#endif
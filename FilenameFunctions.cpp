@@ -30,74 +30,287 @@
 #include <SdFat.h>
 extern SdFat sd;
 
-SdFile file;
+// Defined in GIFPackFunctions.cpp
+extern int gifPackOpen(const char *directoryName);
+extern boolean gifPackGetName(int index, char *filename);
 
 int numberOfFiles;
 
-// Enumerate and possibly display the animated GIF filenames in GIFS directory
-int enumerateGIFFiles(const char *directoryName, boolean displayFilenames) {
+// Directory index
+// The GIF files of a directory are listed in an index the first time the
+// directory is enumerated so a file can be found by its number without
+// reading the directory again. The index of /gengifs/ is kept on the card
+// in /gengifs/_index/_DIR.IDX and is rebuilt when the modification time of
+// the directory, the number of its entries or the total size of its files
+// changes. The entries are counted each time the directory is enumerated, as
+// adding or removing files doesn't always change the time of the directory
+#define DIRECTORY_INDEX_DIRECTORY "_index"
+#define DIRECTORY_INDEX_FILENAME  "_DIR.IDX"
+#define DIRECTORY_INDEX_MAGIC     "DIDX"
+#define DIRECTORY_INDEX_VERSION   2
+
+// Number of index entries kept in RAM. The entries of larger directories
+// are read from the index on the card
+#define DIRECTORY_INDEX_RAM_ENTRIES 64
+
+// Index file header, followed by an entry for every file
+typedef struct {
+    char magic[4];
+    byte version;
+    byte reserved;
+    uint16_t count;             // Number of files
+    uint32_t dirCluster;        // First cluster and modification time of the
+    uint16_t dirDate;           // directory the index was made from
+    uint16_t dirTime;
+    uint16_t dirEntries;        // Number of entries and total size of the
+    uint16_t reserved2;         // files in it
+    uint32_t dirSize;
+}
+DirectoryIndexHeader;
 
-    numberOfFiles = 0;
+// Files are opened by their pathname so only the name is kept
+typedef struct {
+    uint8_t name[11];           // 8.3 name as stored in the directory entry
+    byte reserved;
+}
+DirectoryIndexEntry;
+
+DirectoryIndexHeader directoryIndexHeader;
+DirectoryIndexEntry directoryIndexEntries[DIRECTORY_INDEX_RAM_ENTRIES];
+char directoryIndexDirectory[50];
+SdFile directoryIndexFile;
+
+// Make the pathname of the index of a directory
+//   directory set to the pathname of the index directory
+//   pathname set to the pathname of the index
+void directoryIndexMakePathname(const char *directoryName, char *directory, char *pathname) {
 
-    // Set the current working directory
-    if (! sd.chdir(directoryName, true)) {
-        sd.errorHalt("Could not change to gifs directory");
+    strcpy(directory, directoryName);
+    int len = strlen(directory);
+    if ((len == 0) || (directory[len - 1] != '/')) {
+        strcat(directory, "/");
     }
-    sd.vwd()->rewind();
+    strcat(directory, DIRECTORY_INDEX_DIRECTORY);
 
-    char fn[13];
-    while (file.openNext(sd.vwd(), O_READ)) {
-        file.getName(fn, 13);
-        // If filename not deleted, count it
-        if (fn[0] != '_') {
-            numberOfFiles++;
-            if (displayFilenames) {
-                Serial.println(fn);
-                delay(20);
-            }
+    strcpy(pathname, directory);
+    strcat(pathname, "/");
+    strcat(pathname, DIRECTORY_INDEX_FILENAME);
+}
+
+// List the GIF files of a directory in the index
+// The index is written to the card as it is built and the first entries are
+// kept in RAM
+void directoryIndexBuild(SdFile &directory, const char *directoryName) {
+
+    char directoryPathname[60];
+    char pathname[70];
+    dir_t entry;
+    DirectoryIndexEntry indexEntry;
+
+    Serial.print("Building directory index: ");
+    Serial.println(directoryName);
+
+    // The index directory may already exist
+    directoryIndexMakePathname(directoryName, directoryPathname, pathname);
+    sd.mkdir(directoryPathname);
+
+    boolean persist = directoryIndexFile.open(pathname, O_RDWR | O_CREAT | O_TRUNC);
+    if (persist) {
+        directoryIndexFile.write(&directoryIndexHeader, sizeof(directoryIndexHeader));
+    }
+    else    {
+        Serial.println("Could not create directory index");
+    }
+
+    directoryIndexHeader.count = 0;
+    directory.rewind();
+
+    while (directory.readDir(&entry) > 0) {
+        // Files whose names start with these chars are not listed
+        if ((! DIR_IS_FILE(&entry)) || (entry.name[0] == '_') || (entry.name[0] == '~')) {
+            continue;
+        }
+        // Without the index on the card only the entries that fit in RAM are kept
+        if ((! persist) && (directoryIndexHeader.count == DIRECTORY_INDEX_RAM_ENTRIES)) {
+            break;
+        }
+        memcpy(indexEntry.name, entry.name, sizeof(indexEntry.name));
+        indexEntry.reserved = 0;
+
+        if (directoryIndexHeader.count < DIRECTORY_INDEX_RAM_ENTRIES) {
+            directoryIndexEntries[directoryIndexHeader.count] = indexEntry;
+        }
+        if (persist) {
+            directoryIndexFile.write(&indexEntry, sizeof(indexEntry));
         }
-        file.close();
+        directoryIndexHeader.count++;
     }
-    // Set the current working directory
-    if (! sd.chdir("/", true)) {
-        sd.errorHalt("Could not change to root directory");
+
+    // Complete the header now everything is known
+    if (persist) {
+        memcpy(directoryIndexHeader.magic, DIRECTORY_INDEX_MAGIC, 4);
+        directoryIndexFile.seekSet(0);
+        directoryIndexFile.write(&directoryIndexHeader, sizeof(directoryIndexHeader));
+        directoryIndexFile.sync();
     }
-    return numberOfFiles;
 }
 
-// Get the full path/filename of the GIF file with specified index
-void getGIFFilenameByIndex(const char *directoryName, int index, char *pnBuffer) {
+// Count the entries of a directory and the total size of its files
+// Entries that are never listed, like the index directory, are left out
+void directoryIndexCount(SdFile &directory, uint16_t *entries, uint32_t *size) {
 
-    char filename[13];
+    dir_t entry;
 
-    // Make sure index is in range
-    if ((index >= 0) && (index < numberOfFiles)) {
+    *entries = 0;
+    *size = 0;
+    directory.rewind();
+
+    while (directory.readDir(&entry) > 0) {
+        if ((entry.name[0] == '_') || (entry.name[0] == '~')) {
+            continue;
+        }
+        (*entries)++;
+        if (DIR_IS_FILE(&entry)) {
+            *size += entry.fileSize;
+        }
+    }
+}
+
+// Load the index of a directory, building it first if there is none or the
+// directory has changed since it was built
+// Returns the number of files in the directory
+int directoryIndexLoad(const char *directoryName) {
+
+    char directoryPathname[60];
+    char pathname[70];
+    dir_t entry;
+    SdFile directory;
+
+    if ((! directory.open(directoryName, O_READ)) || (! directory.isDir())) {
+        sd.errorHalt("Could not open gifs directory");
+    }
+    memset(&entry, 0, sizeof(entry));
+    directory.dirEntry(&entry);
 
-        // Set the current working directory
-        if (! sd.chdir(directoryName, true)) {
-            sd.errorHalt("Could not change to gifs directory");
+    uint32_t dirCluster = directory.firstCluster();
+    uint16_t dirEntries;
+    uint32_t dirSize;
+    directoryIndexCount(directory, &dirEntries, &dirSize);
+
+    // The index in RAM is good if the directory hasn't changed
+    if ((strcmp(directoryName, directoryIndexDirectory) == 0) &&
+        (directoryIndexHeader.dirCluster == dirCluster) &&
+        (directoryIndexHeader.dirDate == entry.lastWriteDate) &&
+        (directoryIndexHeader.dirTime == entry.lastWriteTime) &&
+        (directoryIndexHeader.dirEntries == dirEntries) &&
+        (directoryIndexHeader.dirSize == dirSize)) {
+        directory.close();
+        return directoryIndexHeader.count;
+    }
+    directoryIndexFile.close();
+    directoryIndexDirectory[0] = '\0';
+
+    // Use the index on the card if it was made from this version of the directory
+    directoryIndexMakePathname(directoryName, directoryPathname, pathname);
+    boolean loaded = false;
+
+    if (directoryIndexFile.open(pathname, O_READ)) {
+        if ((directoryIndexFile.read(&directoryIndexHeader, sizeof(directoryIndexHeader)) == sizeof(directoryIndexHeader)) &&
+            (strncmp(directoryIndexHeader.magic, DIRECTORY_INDEX_MAGIC, 4) == 0) &&
+            (directoryIndexHeader.version == DIRECTORY_INDEX_VERSION) &&
+            (directoryIndexHeader.dirCluster == dirCluster) &&
+            (directoryIndexHeader.dirDate == entry.lastWriteDate) &&
+            (directoryIndexHeader.dirTime == entry.lastWriteTime) &&
+            (directoryIndexHeader.dirEntries == dirEntries) &&
+            (directoryIndexHeader.dirSize == dirSize)) {
+            int bytes = min((int) directoryIndexHeader.count, DIRECTORY_INDEX_RAM_ENTRIES) * sizeof(DirectoryIndexEntry);
+            loaded = (directoryIndexFile.read(directoryIndexEntries, bytes) == bytes);
+        }
+        if (! loaded) {
+            directoryIndexFile.close();
         }
+    }
+    if (! loaded) {
+        memset(&directoryIndexHeader, 0, sizeof(directoryIndexHeader));
+        directoryIndexHeader.version = DIRECTORY_INDEX_VERSION;
+        directoryIndexHeader.dirCluster = dirCluster;
+        directoryIndexHeader.dirDate = entry.lastWriteDate;
+        directoryIndexHeader.dirTime = entry.lastWriteTime;
+        directoryIndexHeader.dirEntries = dirEntries;
+        directoryIndexHeader.dirSize = dirSize;
+        directoryIndexBuild(directory, directoryName);
+    }
+    directory.close();
+
+    strcpy(directoryIndexDirectory, directoryName);
+    return directoryIndexHeader.count;
+}
+
+// Get the name of the file with the specified index from the loaded index
+// Returns false if there is no such file
+boolean directoryIndexGetName(int index, char *filename) {
 
-        // Make sure file is closed before starting
-        file.close();
+    DirectoryIndexEntry indexEntry;
+    dir_t entry;
 
-        // Rewind the directory to the beginning
-        sd.vwd()->rewind();
+    if ((index < 0) || (index >= directoryIndexHeader.count)) {
+        return false;
+    }
+    if (index < DIRECTORY_INDEX_RAM_ENTRIES) {
+        indexEntry = directoryIndexEntries[index];
+    }
+    else    {
+        directoryIndexFile.seekSet(sizeof(DirectoryIndexHeader) + ((uint32_t) index * sizeof(DirectoryIndexEntry)));
+        if (directoryIndexFile.read(&indexEntry, sizeof(indexEntry)) != sizeof(indexEntry)) {
+            return false;
+        }
+    }
+    memcpy(entry.name, indexEntry.name, sizeof(entry.name));
+    SdBaseFile::dirName(entry, filename);
+    return true;
+}
 
-        while ((file.openNext(sd.vwd(), O_READ)) && (index >= 0)) {
+// Enumerate and possibly display the animated GIF filenames in GIFS directory
+// The files of a directory with a GIF pack are listed from the pack
+int enumerateGIFFiles(const char *directoryName, boolean displayFilenames) {
 
-            file.getName(filename, 13);
+    int packCount = gifPackOpen(directoryName);
+    boolean packed = (packCount != 0);
+    numberOfFiles = packed ? packCount : directoryIndexLoad(directoryName);
 
-            // If filename is not marked as deleted, count it
-            if ((filename[0] != '_') && (filename[0] != '~')) {
-                index--;
+    if (displayFilenames) {
+        char fn[13];
+        for (int index = 0; index < numberOfFiles; index++) {
+            if (packed ? gifPackGetName(index, fn) : directoryIndexGetName(index, fn)) {
+                Serial.println(fn);
+                delay(20);
             }
-            file.close();
         }
-        // Set the current working directory back to root
-        if (! sd.chdir("/", true)) {
-            sd.errorHalt("Could not change to root directory");
+    }
+    return numberOfFiles;
+}
+
+// Get the full path/filename of the GIF file with specified index
+void getGIFFilenameByIndex(const char *directoryName, int index, char *pnBuffer) {
+
+    char filename[13];
+    boolean found;
+
+    if (gifPackOpen(directoryName) != 0) {
+        found = gifPackGetName(index, filename);
+    }
+    else    {
+        // The index of another directory may have been loaded since this one
+        // was enumerated
+        if (strcmp(directoryName, directoryIndexDirectory) != 0) {
+            directoryIndexLoad(directoryName);
         }
+        found = directoryIndexGetName(index, filename);
+    }
+
+    // Make sure index is in range
+    if ((index >= 0) && (index < numberOfFiles) && found) {
+
         // Copy the directory name into the pathname buffer
         strcpy(pnBuffer, directoryName);
 
@@ -112,10 +325,3 @@ void chooseRandomGIFFilename(const char *directoryName, char *pnBuffer) {
     int index = random(numberOfFiles);    
     getGIFFilenameByIndex(directoryName, index, pnBuffer);
 }
-
-
-
-
-
-
-
@@ -0,0 +1,388 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to cache the decoded frames of an animated GIF
+ * so that later loops of the animation can be replayed without reading the
+ * SD card or running the LZW decoder
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Codes.h"
+#include "GifDecoder.h"
+
+#include "SmartMatrix.h"
+extern SmartMatrix matrix;
+
+const int WIDTH  = 32;
+const int HEIGHT = 32;
+
+// Defined in GIFParseFunctions.cpp
+extern void presentFrame(int delayTime);
+extern void extendFrame(int delayTime);
+
+// Cache states
+#define CACHE_EMPTY     0
+#define CACHE_RECORDING 1
+#define CACHE_COMPLETE  2
+#define CACHE_TOO_BIG   3
+
+// Frame flags
+#define CACHE_FRAME_CLEAR   0x01    // An area is cleared before the frame is drawn
+#define CACHE_FRAME_PALETTE 0x02    // Frame carries a new palette
+#define CACHE_FRAME_REPEAT  0x04    // Frame is the same as the one before it
+
+// Each cached frame is stored as
+//   flags, delay (2 bytes)
+//   unless CACHE_FRAME_REPEAT: x, y, width, height
+//   if CACHE_FRAME_CLEAR: x, y, width and height of the area to clear
+//   if CACHE_FRAME_PALETTE: color count - 1 and the palette colors
+//   pairs of skip count and literal count covering the frame rectangle,
+//   each literal count followed by that many palette indices
+// Skipped pixels are transparent or unchanged from the previous frame
+
+// The RAM of the cache is given to it by frameCacheInit(). It starts with
+// the palette indices last drawn on screen while recording and which of them
+// are known, followed by the cached frames
+#define CACHE_SCREEN_SIZE (WIDTH * HEIGHT)
+#define CACHE_KNOWN_SIZE  ((WIDTH * HEIGHT) / 8)
+
+byte *frameCacheScreen;
+byte *frameCacheKnown;
+byte *frameCache;
+int frameCacheSize;
+int frameCacheUsed;
+int frameCacheState;
+char frameCachePathname[50];
+
+// Give the cache its RAM
+//   ram the RAM, which the cache shares with the games
+//   size the size of the RAM in bytes. The cache is off if it holds no frames
+void frameCacheInit(byte *ram, int size) {
+
+    frameCacheScreen = ram;
+    frameCacheKnown = ram + CACHE_SCREEN_SIZE;
+    frameCache = frameCacheKnown + CACHE_KNOWN_SIZE;
+    frameCacheSize = max(size - (CACHE_SCREEN_SIZE + CACHE_KNOWN_SIZE), 0);
+
+    frameCacheUsed = 0;
+    frameCacheState = CACHE_EMPTY;
+    frameCachePathname[0] = '\0';
+}
+
+// Drop the cached frames before the RAM of the cache is used for a game
+void frameCacheClear() {
+
+    frameCacheState = CACHE_EMPTY;
+    frameCachePathname[0] = '\0';
+}
+
+// Append a byte to the cache
+// Returns false and abandons caching of the file if the cache is full
+boolean frameCachePut(byte b) {
+
+    if (frameCacheUsed >= frameCacheSize) {
+        Serial.println("Frame cache full - animation will be streamed");
+        frameCacheState = CACHE_TOO_BIG;
+        return false;
+    }
+    frameCache[frameCacheUsed++] = b;
+    return true;
+}
+
+// Determine if the cache holds all of the frames of the specified file
+boolean frameCacheHolds(const char *pathname) {
+
+    return (frameCacheState == CACHE_COMPLETE) && (strcmp(pathname, frameCachePathname) == 0);
+}
+
+// Determine if the specified file is known to be too big to cache
+boolean frameCacheTooBig(const char *pathname) {
+
+    return (frameCacheState == CACHE_TOO_BIG) && (strcmp(pathname, frameCachePathname) == 0);
+}
+
+// Start recording the frames of the specified file
+void frameCacheBegin(const char *pathname) {
+
+    strncpy(frameCachePathname, pathname, sizeof(frameCachePathname) - 1);
+    frameCachePathname[sizeof(frameCachePathname) - 1] = '\0';
+
+    frameCacheUsed = 0;
+
+    // Every file is streamed when the cache is off
+    if (frameCacheSize == 0) {
+        frameCacheState = CACHE_TOO_BIG;
+        return;
+    }
+    frameCacheState = CACHE_RECORDING;
+
+    // Nothing is known about the screen content
+    memset(frameCacheKnown, 0, CACHE_KNOWN_SIZE);
+}
+
+// Record the frame the decoder has just drawn
+void frameCacheAddFrame(GifDecoder &decoder) {
+
+    if (frameCacheState != CACHE_RECORDING) {
+        return;
+    }
+    int tbiImageX = decoder.getFrameX();
+    int tbiImageY = decoder.getFrameY();
+    int tbiWidth = decoder.getFrameWidth();
+    int tbiHeight = decoder.getFrameHeight();
+    int frameDelay = decoder.getFrameDelay();
+    int transparentColorIndex = decoder.getTransparentColorIndex();
+    int disposeMethod = decoder.getDisposeMethod();
+    boolean clearRect = (disposeMethod == DISPOSAL_BACKGROUND);
+    boolean newPalette = decoder.getNewPalette();
+    byte *imageData = decoder.getImageData();
+
+    // Frames must lie within the display to be cached
+    // Restored pixels aren't recorded so files that use restore disposal
+    // are streamed
+    if (decoder.isScaled() || (disposeMethod == DISPOSAL_RESTORE) || (tbiImageX < 0) || (tbiImageY < 0) ||
+        (tbiImageX + tbiWidth > WIDTH) || (tbiImageY + tbiHeight > HEIGHT)) {
+        frameCacheState = CACHE_TOO_BIG;
+        return;
+    }
+    // Only the delay of a repeated frame is needed
+    if (decoder.getFrameRepeated()) {
+        frameCachePut(CACHE_FRAME_REPEAT);
+        frameCachePut(frameDelay & 0xFF);
+        frameCachePut(frameDelay >> 8);
+        return;
+    }
+    // The first frame always carries the palette
+    if (frameCacheUsed == 0) {
+        newPalette = true;
+    }
+    // Pixels drawn with a different palette are unknown
+    if (newPalette) {
+        memset(frameCacheKnown, 0, CACHE_KNOWN_SIZE);
+    }
+
+    byte flags = (clearRect ? CACHE_FRAME_CLEAR : 0) | (newPalette ? CACHE_FRAME_PALETTE : 0);
+
+    frameCachePut(flags);
+    frameCachePut(frameDelay & 0xFF);
+    frameCachePut(frameDelay >> 8);
+    frameCachePut(tbiImageX);
+    frameCachePut(tbiImageY);
+    frameCachePut(tbiWidth);
+    frameCachePut(tbiHeight);
+
+    if (clearRect) {
+        int clearX = decoder.getDisposeX();
+        int clearY = decoder.getDisposeY();
+        int clearWidth = decoder.getDisposeWidth();
+        int clearHeight = decoder.getDisposeHeight();
+
+        frameCachePut(clearX);
+        frameCachePut(clearY);
+        frameCachePut(clearWidth);
+        frameCachePut(clearHeight);
+
+        // Cleared pixels are unknown
+        for (int y = clearY; y < clearY + clearHeight; y++) {
+            for (int x = clearX; x < clearX + clearWidth; x++) {
+                int offset = (y * WIDTH) + x;
+                frameCacheKnown[offset >> 3] &= ~(1 << (offset & 7));
+            }
+        }
+    }
+
+    if (newPalette) {
+        int colorCount = decoder.getColorCount();
+        RGB *gifPalette = decoder.getPalette();
+
+        frameCachePut(colorCount - 1);
+        for (int i = 0; i < colorCount; i++) {
+            frameCachePut(gifPalette[i].Red);
+            frameCachePut(gifPalette[i].Green);
+            frameCachePut(gifPalette[i].Blue);
+        }
+    }
+
+    // Encode the frame rectangle as runs of skipped and drawn pixels
+    int skip = 0;
+    int literalCountOffset = -1;
+
+    for (int y = tbiImageY; y < tbiHeight + tbiImageY; y++) {
+        int yOffset = y * WIDTH;
+        for (int x = tbiImageX; x < tbiWidth + tbiImageX; x++) {
+            if (frameCacheState != CACHE_RECORDING) {
+                return;
+            }
+            int offset = yOffset + x;
+            int pixel = imageData[offset];
+            byte bit = 1 << (offset & 7);
+            boolean known = (frameCacheKnown[offset >> 3] & bit) != 0;
+
+            if ((pixel == transparentColorIndex) ||
+                (known && (frameCacheScreen[offset] == pixel))) {
+                // Close any open literal run
+                literalCountOffset = -1;
+                if (skip == 255) {
+                    frameCachePut(skip);
+                    frameCachePut(0);
+                    skip = 0;
+                }
+                skip++;
+                continue;
+            }
+            // Start a new literal run if needed
+            if ((literalCountOffset < 0) || (frameCache[literalCountOffset] == 255)) {
+                frameCachePut(skip);
+                literalCountOffset = frameCacheUsed;
+                frameCachePut(0);
+                skip = 0;
+            }
+            if (! frameCachePut(pixel)) {
+                return;
+            }
+            frameCache[literalCountOffset]++;
+
+            frameCacheScreen[offset] = pixel;
+            frameCacheKnown[offset >> 3] |= bit;
+        }
+    }
+    // Account for any trailing skipped pixels
+    if (skip != 0) {
+        frameCachePut(skip);
+        frameCachePut(0);
+    }
+}
+
+// Finish recording the file
+//   complete true if every frame of the file was recorded
+void frameCacheEnd(boolean complete) {
+
+    if (frameCacheState != CACHE_RECORDING) {
+        return;
+    }
+    if (complete) {
+        frameCacheState = CACHE_COMPLETE;
+
+        Serial.print("Frame cache used: ");
+        Serial.println(frameCacheUsed);
+    }
+    else    {
+        frameCacheState = CACHE_EMPTY;
+    }
+}
+
+// Draw a cached frame into the back buffer
+//   p the frame data following the delay
+//   flags the frame flags
+//   palette the palette being drawn with, replaced if the frame carries one
+// Returns a pointer to the next frame
+byte *frameCacheDrawFrame(byte *p, byte flags, RGB **palette) {
+
+    int x0 = *p++;
+    int y0 = *p++;
+    int width = *p++;
+    int height = *p++;
+
+    if (flags & CACHE_FRAME_CLEAR) {
+        rgb24 *dst = matrix.backBuffer() + (p[1] * WIDTH) + p[0];
+        int rowBytes = p[2] * sizeof(rgb24);
+        int rows = p[3];
+        p += 4;
+
+        while (rows--) {
+            memset(dst, 0, rowBytes);
+            dst += WIDTH;
+        }
+    }
+    if (flags & CACHE_FRAME_PALETTE) {
+        int colors = *p++ + 1;
+        *palette = (RGB *) p;
+        p += colors * 3;
+    }
+
+    // Draw the runs of changed pixels straight into the back buffer
+    // Cached frames always lie within the display
+    rgb24 *backBuffer = matrix.backBuffer();
+    RGB *colors = *palette;
+
+    int pixelCount = width * height;
+    int pos = 0;
+    int x = 0;
+    int y = 0;
+    while (pos < pixelCount) {
+        // Move past the skipped pixels
+        int skip = *p++;
+        int count = *p++;
+        pos += skip + count;
+        x += skip;
+        while (x >= width) {
+            x -= width;
+            y++;
+        }
+        rgb24 *dst = backBuffer + ((y0 + y) * WIDTH) + x0 + x;
+        while (count--) {
+            RGB *color = &colors[*p++];
+            dst->red = color->Red;
+            dst->green = color->Green;
+            dst->blue = color->Blue;
+            dst++;
+            if (++x == width) {
+                x = 0;
+                y++;
+                dst = backBuffer + ((y0 + y) * WIDTH) + x0;
+            }
+        }
+    }
+    return p;
+}
+
+// Display all frames held in the cache
+// Returns an IR code if the user wants to abort the animation
+unsigned long frameCachePlay(unsigned long (*checkForInput)()) {
+
+    RGB *palette = NULL;
+    byte *p = frameCache;
+    byte *end = frameCache + frameCacheUsed;
+
+    while (p < end) {
+        // Read frame header
+        byte flags = *p++;
+        int delayTime = p[0] | (p[1] << 8);
+        p += 2;
+
+        if (flags & CACHE_FRAME_REPEAT) {
+            extendFrame(delayTime * 10);
+        }
+        else    {
+            p = frameCacheDrawFrame(p, flags, &palette);
+            presentFrame(delayTime * 10);
+        }
+
+        // Check to see if user wants to abort current animation
+        unsigned long input = checkForInput();
+        if ((input == IRCODE_HOME) || (input == IRCODE_RIGHT) || (input == IRCODE_LEFT)) {
+            return input;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to build and read the frame index of animated
+ * GIF files. The index of a file is kept in a sidecar file and lists the
+ * position, delay and disposal method of every frame so that any frame can
+ * be reached, and the length of the animation known, without decoding the
+ * frames before it
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "GifDecoder.h"
+
+#include <SdFat.h>
+extern SdFat sd;
+
+// Defined in GIFPackFunctions.cpp
+extern boolean gifPackDirEntry(const char *pathname, dir_t *entry);
+
+// The index of /gengifs/NAME.GIF is /gengifs/_index/NAME.GIF
+// Names starting with an underscore are ignored when GIF files are listed
+#define FRAME_INDEX_DIRECTORY "_index"
+
+#define FRAME_INDEX_MAGIC   "GIDX"
+#define FRAME_INDEX_VERSION 1
+
+// Index file header, followed by a GifFrameInfo for every frame
+typedef struct {
+    char magic[4];
+    byte version;
+    byte reserved;
+    int16_t loopCount;          // Netscape loop count or NO_LOOP_COUNT
+    uint32_t gifSize;           // Size and modification time of the GIF file
+    uint16_t gifDate;           // the index was made from
+    uint16_t gifTime;
+    uint16_t frameCount;
+    uint16_t reserved2;
+    uint32_t duration;          // Length of one loop in 1/100 s
+}
+FrameIndexHeader;
+
+SdFile frameIndexFile;
+FrameIndexHeader frameIndexHeader;
+char frameIndexPathname[50];
+boolean frameIndexLoaded;
+
+// Make the pathname of the index of a GIF file
+//   directory set to the pathname of the index directory
+//   indexPathname set to the pathname of the index
+// Returns false if the pathname is not that of a GIF file
+boolean frameIndexMakePathname(const char *pathname, char *directory, char *indexPathname) {
+
+    const char *name = strrchr(pathname, '/');
+    name = (name == NULL) ? pathname : name + 1;
+
+    // Only GIF files are indexed
+    int len = strlen(name);
+    if ((len < 5) || (strcasecmp(name + len - 4, ".gif") != 0) ||
+        (strlen(pathname) + strlen(FRAME_INDEX_DIRECTORY) + 2 > sizeof(frameIndexPathname))) {
+        return false;
+    }
+    strncpy(directory, pathname, name - pathname);
+    directory[name - pathname] = '\0';
+    strcat(directory, FRAME_INDEX_DIRECTORY);
+
+    strcpy(indexPathname, directory);
+    strcat(indexPathname, "/");
+    strcat(indexPathname, name);
+    return true;
+}
+
+// Scan all frames of a GIF file and write its index
+//   opened if not NULL, the decoder is left with the file open at its first
+//   frame rather than closed, so a file that was read ahead isn't opened
+//   again, and this is set to true
+boolean frameIndexBuild(GifDecoder &decoder, const char *pathname, const char *directory,
+                        const char *indexPathname, dir_t *gifEntry, boolean *opened) {
+
+    GifFrameInfo info;
+
+    Serial.print("Building frame index: ");
+    Serial.println(indexPathname);
+
+    if (decoder.open(pathname) != ERROR_NONE) {
+        return false;
+    }
+    // The index directory may already exist
+    sd.mkdir(directory);
+
+    if (! frameIndexFile.open(indexPathname, O_RDWR | O_CREAT | O_TRUNC)) {
+        Serial.println("Could not create frame index");
+        decoder.close();
+        return false;
+    }
+
+    memset(&frameIndexHeader, 0, sizeof(frameIndexHeader));
+    frameIndexFile.write(&frameIndexHeader, sizeof(frameIndexHeader));
+
+    int result;
+    while ((result = decoder.scanFrame(&info)) == FRAME_DECODED) {
+        frameIndexFile.write(&info, sizeof(info));
+        frameIndexHeader.frameCount++;
+        frameIndexHeader.duration += info.delay;
+    }
+
+    if ((result != ERROR_NONE) || (frameIndexHeader.frameCount == 0)) {
+        decoder.close();
+        frameIndexFile.remove();
+        return false;
+    }
+    if ((opened != NULL) && (decoder.rewind() == ERROR_NONE)) {
+        *opened = true;
+    }
+    else    {
+        decoder.close();
+    }
+
+    // Complete the header now everything is known
+    memcpy(frameIndexHeader.magic, FRAME_INDEX_MAGIC, 4);
+    frameIndexHeader.version = FRAME_INDEX_VERSION;
+    frameIndexHeader.loopCount = decoder.getLoopCount();
+    frameIndexHeader.gifSize = gifEntry->fileSize;
+    frameIndexHeader.gifDate = gifEntry->lastWriteDate;
+    frameIndexHeader.gifTime = gifEntry->lastWriteTime;
+
+    frameIndexFile.seekSet(0);
+    frameIndexFile.write(&frameIndexHeader, sizeof(frameIndexHeader));
+    frameIndexFile.sync();
+    return true;
+}
+
+// Load the index of a GIF file if there is one made from this version of
+// the file
+//   gifEntry the directory entry of the GIF file
+// Returns false if the file has no up to date index
+boolean frameIndexLoadExisting(const char *pathname, dir_t *gifEntry) {
+
+    char directory[50];
+    char indexPathname[50];
+
+    if (frameIndexLoaded && (strcmp(pathname, frameIndexPathname) == 0)) {
+        return true;
+    }
+    frameIndexFile.close();
+    frameIndexLoaded = false;
+
+    if (! frameIndexMakePathname(pathname, directory, indexPathname)) {
+        return false;
+    }
+    if (frameIndexFile.open(indexPathname, O_READ)) {
+        if ((frameIndexFile.read(&frameIndexHeader, sizeof(frameIndexHeader)) == sizeof(frameIndexHeader)) &&
+            (strncmp(frameIndexHeader.magic, FRAME_INDEX_MAGIC, 4) == 0) &&
+            (frameIndexHeader.version == FRAME_INDEX_VERSION) &&
+            (frameIndexHeader.gifSize == gifEntry->fileSize) &&
+            (frameIndexHeader.gifDate == gifEntry->lastWriteDate) &&
+            (frameIndexHeader.gifTime == gifEntry->lastWriteTime)) {
+            frameIndexLoaded = true;
+            strcpy(frameIndexPathname, pathname);
+        }
+        else    {
+            frameIndexFile.close();
+        }
+    }
+    return frameIndexLoaded;
+}
+
+// Load the index of a GIF file, building it first if there is none or the
+// GIF file has changed since it was built
+//   opened if not NULL, set to true if the index was built and the decoder
+//   left with the file open at its first frame, false if the decoder is closed
+// Returns false if the file has no index
+boolean frameIndexLoad(GifDecoder &decoder, const char *pathname, boolean *opened) {
+
+    char directory[50];
+    char indexPathname[50];
+    dir_t gifEntry;
+    SdFile gifFile;
+
+    if (opened != NULL) {
+        *opened = false;
+    }
+    if (frameIndexLoaded && (strcmp(pathname, frameIndexPathname) == 0)) {
+        return true;
+    }
+    frameIndexFile.close();
+    frameIndexLoaded = false;
+
+    if (! frameIndexMakePathname(pathname, directory, indexPathname)) {
+        return false;
+    }
+    // A file in a GIF pack is checked against the pack
+    if (! gifPackDirEntry(pathname, &gifEntry)) {
+        if ((! gifFile.open(pathname)) || (! gifFile.dirEntry(&gifEntry))) {
+            return false;
+        }
+        gifFile.close();
+    }
+
+    // Use the existing index if it was made from this version of the file
+    if (! frameIndexLoadExisting(pathname, &gifEntry)) {
+        frameIndexLoaded = frameIndexBuild(decoder, pathname, directory, indexPathname, &gifEntry, opened);
+        if (frameIndexLoaded) {
+            strcpy(frameIndexPathname, pathname);
+        }
+    }
+    return frameIndexLoaded;
+}
+
+// Number of frames in the loaded index
+int frameIndexFrameCount() {
+
+    return frameIndexHeader.frameCount;
+}
+
+// Netscape loop count of the loaded index
+int frameIndexLoopCount() {
+
+    return frameIndexHeader.loopCount;
+}
+
+// Length of one loop of the loaded index in ms
+unsigned long frameIndexDuration() {
+
+    return frameIndexHeader.duration * 10;
+}
+
+// Get the description of a frame from the loaded index
+boolean frameIndexGetFrame(int frameNumber, GifFrameInfo *info) {
+
+    if ((frameNumber < 0) || (frameNumber >= frameIndexHeader.frameCount)) {
+        return false;
+    }
+    frameIndexFile.seekSet(sizeof(FrameIndexHeader) + ((uint32_t) frameNumber * sizeof(GifFrameInfo)));
+    return frameIndexFile.read(info, sizeof(GifFrameInfo)) == sizeof(GifFrameInfo);
+}
+
+// Find the first key frame after a file position in the loaded index
+//   pathname the file the index has to be that of
+//   position the file position to search from
+// Returns false if the index of the file isn't loaded or no key frame follows
+boolean frameIndexFindNextKeyFrame(const char *pathname, uint32_t position, GifFrameInfo *info) {
+
+    if ((! frameIndexLoaded) || (strcmp(pathname, frameIndexPathname) != 0)) {
+        return false;
+    }
+    for (int frameNumber = 0; frameIndexGetFrame(frameNumber, info); frameNumber++) {
+        if ((info->position > position) && (info->flags & FRAME_KEY)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the key frame decoding has to start at to reach a frame
+// Returns the number of the key frame with its description in info
+int frameIndexFindKeyFrame(int frameNumber, GifFrameInfo *info) {
+
+    while (frameIndexGetFrame(frameNumber, info) && ((info->flags & FRAME_KEY) == 0)) {
+        frameNumber--;
+    }
+    return frameNumber;
+}
@@ -0,0 +1,137 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to measure how fast the animated GIF files of a
+ * directory are decoded. Every frame of every file is decoded and drawn as
+ * fast as possible and the statistics of each file are printed as lines of
+ * comma separated values so that runs can be logged and compared
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Codes.h"
+
+#include "GifDecoder.h"
+
+// Defined in GIFParseFunctions.cpp
+extern GifDecoder gifDecoder;
+
+// Defined in FilenameFunctions.cpp
+extern int enumerateGIFFiles(const char *directoryName, boolean displayFilenames);
+extern void getGIFFilenameByIndex(const char *directoryName, int index, char *pnBuffer);
+
+// Every line of benchmark output starts with this tag so it can be picked
+// out of the rest of the serial output
+#define BENCHMARK_TAG "BENCH,"
+
+// Print the statistics of one file or of the whole run
+void benchmarkPrint(const char *name, unsigned long time, const GifDecoderStats &stats) {
+
+    // Rates are per second, the time is in microseconds
+    float seconds = time / 1000000.0;
+    if (seconds == 0) {
+        seconds = 0.000001;
+    }
+
+    Serial.print(BENCHMARK_TAG);
+    Serial.print(name);
+    Serial.print(",");
+    Serial.print(stats.frames);
+    Serial.print(",");
+    Serial.print(time);
+    Serial.print(",");
+    Serial.print(stats.frames / seconds, 1);
+    Serial.print(",");
+    Serial.print(stats.lzwCodes);
+    Serial.print(",");
+    Serial.print(stats.lzwCodes / seconds, 0);
+    Serial.print(",");
+    Serial.print(stats.bytesRead);
+    Serial.print(",");
+    Serial.print(stats.sdCalls);
+    Serial.print(",");
+    Serial.print(stats.peakTableSize);
+    Serial.print(",");
+    Serial.println(stats.peakFrameSize);
+}
+
+// Decode and draw every frame of a gif file without waiting between frames
+//   time set to the time taken in microseconds
+// Returns ERROR_NONE or an error code
+int benchmarkGIFFile(const char *pathname, unsigned long *time) {
+
+    unsigned long startTime = micros();
+
+    int result = gifDecoder.open(pathname);
+    if (result != ERROR_NONE) {
+        return result;
+    }
+    while ((result = gifDecoder.decodeFrame()) == FRAME_DECODED) {
+        gifDecoder.drawFrame();
+    }
+    *time = micros() - startTime;
+
+    gifDecoder.close();
+    return result;
+}
+
+// Benchmark the gif files of a directory
+// Prints a header line, a line for each file and a line for the whole
+// directory. Files that fail to decode are reported but left out of the total
+void benchmarkGIFFiles(const char *directoryName) {
+
+    char pathname[50];
+    GifDecoderStats total;
+    unsigned long totalTime = 0;
+
+    memset(&total, 0, sizeof(total));
+
+    Serial.print(BENCHMARK_TAG);
+    Serial.println("file,frames,us,frames/s,lzw codes,codes/s,bytes read,sd calls,peak table,peak frame");
+
+    int numberOfFiles = enumerateGIFFiles(directoryName, false);
+
+    for (int index = 0; index < numberOfFiles; index++) {
+        getGIFFilenameByIndex(directoryName, index, pathname);
+
+        unsigned long time;
+        int result = benchmarkGIFFile(pathname, &time);
+        if (result != ERROR_NONE) {
+            Serial.print(BENCHMARK_TAG);
+            Serial.print(pathname);
+            Serial.print(",error ");
+            Serial.println(result);
+            continue;
+        }
+        const GifDecoderStats &stats = gifDecoder.getStats();
+        benchmarkPrint(pathname, time, stats);
+
+        total.frames += stats.frames;
+        total.lzwCodes += stats.lzwCodes;
+        total.bytesRead += stats.bytesRead;
+        total.sdCalls += stats.sdCalls;
+        total.peakTableSize = max(total.peakTableSize, stats.peakTableSize);
+        total.peakFrameSize = max(total.peakFrameSize, stats.peakFrameSize);
+        totalTime += time;
+    }
+    benchmarkPrint("total", totalTime, total);
+}
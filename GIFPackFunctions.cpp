@@ -0,0 +1,237 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to read GIF packs. A GIF pack holds all of the
+ * animated GIF files of a directory back to back in a single file, made by
+ * tools/gifpack.py, so the animations are reached with a seek in a file
+ * that stays open rather than by opening a file through the directory
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "GifDecoder.h"
+
+#include <SdFat.h>
+extern SdFat sd;
+
+// GIF pack file layout, all values little endian
+//   magic "GPAK", version, reserved, file count (2 bytes)
+//   table of contents sorted by name, per file
+//     8.3 name (13 bytes), reserved (3 bytes),
+//     offset of the file in the pack (4 bytes), size of the file (4 bytes)
+//   the GIF files, each one starting on an SD card block boundary
+// The GIF pack of "/gengifs/" is "/gengifs.gpk"
+#define GIF_PACK_MAGIC       "GPAK"
+#define GIF_PACK_VERSION     1
+#define GIF_PACK_EXTENSION   ".gpk"
+#define GIF_PACK_HEADER_SIZE 8
+#define GIF_PACK_NAME_SIZE   13
+
+typedef struct {
+    char name[GIF_PACK_NAME_SIZE];
+    byte reserved[3];
+    uint32_t offset;
+    uint32_t size;
+}
+GifPackEntry;
+
+SdFile gifPackFile;
+int gifPackCount;
+
+// Directory the open pack, or the lack of one, was looked for
+char gifPackDirectory[50];
+
+// First SD card block of a pack stored in consecutive blocks or 0
+uint32_t gifPackBlock;
+
+// Most recently read table of contents entry
+GifPackEntry gifPackEntry;
+int gifPackEntryIndex = -1;
+
+// Open the GIF pack of the specified directory
+// The pack stays open until the pack of another directory is asked for
+// Returns the number of files in the pack or 0 if there is none
+int gifPackOpen(const char *directoryName) {
+
+    char pathname[50];
+    char magic[4];
+    byte header[4];
+
+    // Make the directory name end in a slash so every form of it matches
+    int len = strlen(directoryName);
+    if ((len == 0) || (len + 2 > (int) sizeof(gifPackDirectory))) {
+        return 0;
+    }
+    strcpy(pathname, directoryName);
+    if (pathname[len - 1] != '/') {
+        strcat(pathname, "/");
+    }
+
+    if (strcmp(pathname, gifPackDirectory) == 0) {
+        return gifPackCount;
+    }
+    strcpy(gifPackDirectory, pathname);
+
+    gifPackFile.close();
+    gifPackCount = 0;
+    gifPackBlock = 0;
+    gifPackEntryIndex = -1;
+
+    // Strip the trailing slash from the directory name
+    len = strlen(pathname);
+    if (len > 1) {
+        pathname[len - 1] = '\0';
+    }
+    if (strlen(pathname) + strlen(GIF_PACK_EXTENSION) >= sizeof(pathname)) {
+        return 0;
+    }
+    strcat(pathname, GIF_PACK_EXTENSION);
+
+    if (! gifPackFile.open(pathname, O_READ)) {
+        return 0;
+    }
+    if ((gifPackFile.read(magic, 4) != 4) || (strncmp(magic, GIF_PACK_MAGIC, 4) != 0) ||
+        (gifPackFile.read(header, 4) != 4) || (header[0] != GIF_PACK_VERSION)) {
+        Serial.println("Bad GIF pack");
+        gifPackFile.close();
+        return 0;
+    }
+    gifPackCount = header[2] | (header[3] << 8);
+
+    // A pack in consecutive blocks is read straight from the card
+    uint32_t lastBlock;
+    if (! gifPackFile.contiguousRange(&gifPackBlock, &lastBlock)) {
+        gifPackBlock = 0;
+    }
+
+    Serial.print("GIF pack: ");
+    Serial.print(pathname);
+    Serial.print(" with ");
+    Serial.print(gifPackCount);
+    Serial.print(" files");
+    Serial.println((gifPackBlock != 0) ? ", contiguous" : "");
+
+    return gifPackCount;
+}
+
+// Read an entry of the table of contents of the open pack into gifPackEntry
+// Returns false if there is no such entry
+boolean gifPackReadEntry(int index) {
+
+    if ((index < 0) || (index >= gifPackCount)) {
+        return false;
+    }
+    if (index == gifPackEntryIndex) {
+        return true;
+    }
+    gifPackEntryIndex = -1;
+    if ((! gifPackFile.seekSet(GIF_PACK_HEADER_SIZE + ((uint32_t) index * sizeof(GifPackEntry)))) ||
+        (gifPackFile.read(&gifPackEntry, sizeof(gifPackEntry)) != sizeof(gifPackEntry))) {
+        return false;
+    }
+    gifPackEntry.name[GIF_PACK_NAME_SIZE - 1] = '\0';
+    gifPackEntryIndex = index;
+    return true;
+}
+
+// Get the name of the file with the specified index from the open pack
+// Returns false if there is no such file
+boolean gifPackGetName(int index, char *filename) {
+
+    if (! gifPackReadEntry(index)) {
+        return false;
+    }
+    strcpy(filename, gifPackEntry.name);
+    return true;
+}
+
+// Find a GIF file in the pack of its directory
+// The table of contents entry of the file is left in gifPackEntry
+// Returns false if the directory has no pack or the file is not in it
+boolean gifPackFindEntry(const char *pathname) {
+
+    char directory[50];
+
+    const char *name = strrchr(pathname, '/');
+    if ((name == NULL) || (name - pathname + 2 > (int) sizeof(directory))) {
+        return false;
+    }
+    name++;
+    strncpy(directory, pathname, name - pathname);
+    directory[name - pathname] = '\0';
+
+    if (gifPackOpen(directory) == 0) {
+        return false;
+    }
+    if ((gifPackEntryIndex >= 0) && (strcasecmp(name, gifPackEntry.name) == 0)) {
+        return true;
+    }
+
+    // Binary search of the table of contents
+    int low = 0;
+    int high = gifPackCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (! gifPackReadEntry(mid)) {
+            return false;
+        }
+        int compare = strcasecmp(name, gifPackEntry.name);
+        if (compare == 0) {
+            return true;
+        }
+        if (compare < 0) {
+            high = mid - 1;
+        }
+        else    {
+            low = mid + 1;
+        }
+    }
+    return false;
+}
+
+// Find a GIF file in the pack of its directory
+//   offset set to the position of the file in the pack
+//   size set to the size of the file
+//   block set to the first SD card block of a contiguous pack or 0
+// Returns the open pack or NULL if the file is not in one
+SdBaseFile *gifPackFind(const char *pathname, uint32_t *offset, uint32_t *size, uint32_t *block) {
+
+    if (! gifPackFindEntry(pathname)) {
+        return NULL;
+    }
+    *offset = gifPackEntry.offset;
+    *size = gifPackEntry.size;
+    *block = gifPackBlock;
+    return &gifPackFile;
+}
+
+// Get the directory entry a GIF file in a pack is checked against
+// This is the entry of the pack with the size of the file
+// Returns false if the file is not in a pack
+boolean gifPackDirEntry(const char *pathname, dir_t *entry) {
+
+    if ((! gifPackFindEntry(pathname)) || (! gifPackFile.dirEntry(entry))) {
+        return false;
+    }
+    entry->fileSize = gifPackEntry.size;
+    return true;
+}
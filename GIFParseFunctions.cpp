@@ -30,157 +30,280 @@
 // NOTE: setting this to 1 will cause parsing to fail at the present time
 #define DEBUG 0
 
+// Setting this to 1 prints the number of SD card calls made for each frame
+#define SD_STATS 0
+
+// Setting this to 1 prints the time taken to draw each frame in microseconds
+#define DRAW_STATS 0
+
 #include "Codes.h"
+#include "GifDecoder.h"
 
 #include "SmartMatrix.h"
 extern SmartMatrix matrix;
 
 #include <SdFat.h>
 extern SdFat sd;
-extern SdFile file;
 
 const int WIDTH  = 32;
 const int HEIGHT = 32;
 
-// Defined in LZWFunctions.cpp
-extern void lzw_decode_init (int csize, byte *buf);
-extern void decompressAndDisplayFrame();
-extern byte imageData[1024];
-extern byte imageDataBU[1024];
-
-// Error codes
-#define ERROR_NONE		    0
-#define ERROR_FILEOPEN		   -1
-#define ERROR_FILENOTGIF	   -2
-#define ERROR_BADGIFFORMAT         -3
-#define ERROR_UNKNOWNCONTROLEXT	   -4
+// Defined in FrameCacheFunctions.cpp
+extern boolean frameCacheHolds(const char *pathname);
+extern boolean frameCacheTooBig(const char *pathname);
+extern void frameCacheBegin(const char *pathname);
+extern void frameCacheAddFrame(GifDecoder &decoder);
+extern void frameCacheEnd(boolean complete);
+extern unsigned long frameCachePlay(unsigned long (*checkForInput)());
+
+// Defined in GIFPackFunctions.cpp
+extern SdBaseFile *gifPackFind(const char *pathname, uint32_t *offset, uint32_t *size, uint32_t *block);
+
+// Defined in GIFPrefetchFunctions.cpp
+extern void gifPrefetchSchedule(boolean enabled, unsigned long endTime);
+extern void gifPrefetchStep(unsigned long deadline);
+extern boolean gifPrefetchReady(const char *pathname);
+extern int gifPrefetchTake(const char *pathname, SdFile &file);
+extern int gifPrefetchRead(uint32_t position, byte *buffer, int count);
+
+// Defined in FrameIndexFunctions.cpp
+extern boolean frameIndexLoad(GifDecoder &decoder, const char *pathname, boolean *opened);
+extern boolean frameIndexFindNextKeyFrame(const char *pathname, uint32_t position, GifFrameInfo *info);
+extern int frameIndexFrameCount();
+extern int frameIndexLoopCount();
+extern unsigned long frameIndexDuration();
+extern int frameIndexFindKeyFrame(int frameNumber, GifFrameInfo *info);
 
 #define GIFHDRTAGNORM   "GIF87a"  // tag in valid GIF file
 #define GIFHDRTAGNORM1  "GIF89a"  // tag in valid GIF file
 #define GIFHDRSIZE 6
 
+// File position of the global color table
+#define GIFGCTPOSITION 13
+
 // Global GIF specific definitions
 #define COLORTBLFLAG    0x80
 #define INTERLACEFLAG   0x40
 #define TRANSPARENTFLAG 0x01
 
-#define NO_TRANSPARENT_INDEX -1
-
-// Disposal methods
-#define DISPOSAL_NONE       0
-#define DISPOSAL_LEAVE      1
-#define DISPOSAL_BACKGROUND 2
-#define DISPOSAL_RESTORE    3
-
-// RGB data structure
-typedef struct {
-    byte Red;
-    byte Green;
-    byte Blue;
-} 
-RGB;
-
-// Logical screen descriptor attributes
-int lsdWidth;
-int lsdHeight;
-int lsdPackedField;
-int lsdAspectRatio;
-int lsdBackgroundIndex;
-
-// Table based image attributes
-int tbiImageX;
-int tbiImageY;
-int tbiWidth;
-int tbiHeight;
-int tbiPackedBits;
-boolean tbiInterlaced;
-
-int frameDelay;
-int transparentColorIndex;
-int prevBackgroundIndex;
-int prevDisposalMethod;
-int disposalMethod;
-int lzwCodeSize;
-boolean keyFrame;
-int rectX;
-int rectY;
-int rectWidth;
-int rectHeight;
-
-int colorCount;
-RGB gifPalette[256];
-
-byte lzwImageData[1024];
-char tempBuffer[260];
+// Frames are shown for at least this long in 1/100 s
+#define MIN_FRAME_DELAY 6
+
+// The decoder used to play animations
+GifDecoder gifDecoder;
+
+// Restore buffer shared by all decoders
+rgb24 GifDecoder::screenBU[1024];
+GifDecoder *GifDecoder::screenBUOwner;
+
+// Pathname of the previously processed file
+char prevPathname[50];
+
+// Discard the content of the read buffer
+// Must be called whenever the file is opened or repositioned
+//   position the position of the next byte to read
+void GifDecoder::resetReadBuffer(uint32_t position) {
+    readBufferIndex = 0;
+    readBufferCount = 0;
+    sourcePosition = position;
+}
+
+// Refill the read buffer from the file
+// Reads are sized so that after the first one they fall on sector boundaries
+// The source is only repositioned when a read doesn't follow on from the last
+// one, as after a seek or when another decoder has read from the same pack
+boolean GifDecoder::fillReadBuffer() {
+
+    uint32_t position = sourceBase + sourcePosition;
+    int offset = position % READ_BUFFER_SIZE;
+    uint32_t remaining = (sourcePosition < sourceSize) ? sourceSize - sourcePosition : 0;
+    int result = 0;
+
+    readBufferIndex = 0;
+    if ((remaining != 0) && (sourcePosition < prefetchedSize)) {
+        // The start of a file read ahead is taken from the prefetch buffer
+        // for as long as that holds it
+        result = gifPrefetchRead(sourcePosition, readBuffer, READ_BUFFER_SIZE - offset);
+        if (result == 0) {
+            prefetchedSize = 0;
+        }
+    }
+    if ((result != 0) || (remaining == 0)) {
+        // Read ahead or end of the GIF data
+    }
+    else if (sourceBlock != 0) {
+        // A contiguous source is read a whole block at a time straight from the card
+        if (sd.card()->readBlock(sourceBlock + (position / READ_BUFFER_SIZE), readBuffer)) {
+            readBufferIndex = offset;
+            result = READ_BUFFER_SIZE;
+        }
+        stats.sdCalls++;
+    }
+    else    {
+        if (source->curPosition() != position) {
+            source->seekSet(position);
+            stats.sdCalls++;
+        }
+        result = source->read(readBuffer, READ_BUFFER_SIZE - offset);
+        stats.sdCalls++;
+    }
+
+    if (result > readBufferIndex) {
+        readBufferCount = readBufferIndex + min((uint32_t) (result - readBufferIndex), remaining);
+    }
+    else    {
+        readBufferIndex = 0;
+        readBufferCount = 0;
+    }
+    stats.bytesRead += readBufferCount - readBufferIndex;
+    sourcePosition += readBufferCount - readBufferIndex;
+
+    return (readBufferCount != 0);
+}
 
 // Backup the read stream by n bytes
-void backUpStream(int n) {
-    file.seekCur(-n);
+void GifDecoder::backUpStream(int n) {
+
+    // Unread within the buffer if possible
+    if (n <= readBufferIndex) {
+        readBufferIndex -= n;
+        return;
+    }
+    // Otherwise read again from the unread position
+    resetReadBuffer(getPosition() - n);
 }
 
 // Read a file byte
-int readByte() {
+int GifDecoder::readByte() {
 
-    int b = file.read();
-    if (b == -1) {
+    if ((readBufferIndex >= readBufferCount) && (! fillReadBuffer())) {
         Serial.println("Read error or EOF occurred");
+        return -1;
     }
-    return b;
+    return readBuffer[readBufferIndex++];
 }
 
 // Read a file word
-int readWord() {
+int GifDecoder::readWord() {
 
     int b0 = readByte();
     int b1 = readByte();    
+    if ((b0 < 0) || (b1 < 0)) {
+        return -1;
+    }
     return (b1 << 8) | b0;
 }
 
 // Read the specified number of bytes into the specified buffer
-int readIntoBuffer(void *buffer, int numberOfBytes) {
+int GifDecoder::readIntoBuffer(void *buffer, int numberOfBytes) {
 
-    int result = file.read(buffer, numberOfBytes);
-    if (result == -1) {
-        Serial.println("Read error or EOF occurred");
+    byte *dst = (byte *) buffer;
+    int result = 0;
+
+    while (result < numberOfBytes) {
+        if ((readBufferIndex >= readBufferCount) && (! fillReadBuffer())) {
+            Serial.println("Read error or EOF occurred");
+            return (result == 0) ? -1 : result;
+        }
+        // Copy as much as is available in the read buffer
+        int count = min(numberOfBytes - result, readBufferCount - readBufferIndex);
+        memcpy(dst + result, readBuffer + readBufferIndex, count);
+        readBufferIndex += count;
+        result += count;
     }
     return result;
 }
 
-// Fill a portion of imageData buffer with a color index
-void fillImageDataRect(byte colorIndex, int x, int y, int width, int height) {
+// Skip over data sub-blocks up to and including the block terminator
+void GifDecoder::skipSubBlocks() {
 
-    int yOffset;
-
-    for (int yy = y; yy < height + y; yy++) {
-        yOffset = yy * WIDTH;
-        for (int xx = x; xx < width + x; xx++) {
-            imageData[yOffset + xx] = colorIndex;
-        }
+    int len = readByte();
+    while (len > 0) {
+        readIntoBuffer(tempBuffer, len);
+        len = readByte();
     }
 }
 
-// Fill entire imageData buffer with a color index
-void fillImageData(byte colorIndex) {
-
-    memset(imageData, colorIndex, sizeof(imageData));
+// Frame presentation scheduler
+// Each frame is shown at an absolute deadline derived from the delays of the
+// frames before it. A frame is decoded into the back buffer while the previous
+// one is still being shown, so decode time is not added to the frame delay
+unsigned long frameDeadline;    // Time at which the next frame is due
+boolean frameDeadlineSync;      // Next frame resynchronizes the deadline
+int lateFrameCount;             // Number of frames shown after their deadline
+unsigned long lateFrameTime;    // Cumulative lateness of those frames in ms
+int skippedFrameCount;          // Number of repeated frames not shown
+
+// Prepare to present the frames of an animation
+//   continueTimeline true if this is another loop of the previous animation
+void frameSchedulerStart(boolean continueTimeline) {
+
+    frameDeadlineSync = true;
+    if (! continueTimeline) {
+        frameDeadline = millis();
+    }
+    lateFrameCount = 0;
+    lateFrameTime = 0;
+    skippedFrameCount = 0;
 }
 
-// Copy image data in rect from a src to a dst
-void copyImageDataRect(byte *src, byte *dst, int x, int y, int width, int height) {
+// Make the frame in the back buffer visible when it is due
+//   delayTime how long the frame is to be shown in ms
+void presentFrame(int delayTime) {
 
-    int yOffset, offset;
+    unsigned long now = millis();
+    long early = (long) (frameDeadline - now);
 
-    for (int yy = y; yy < height + y; yy++) {
-        yOffset = yy * WIDTH;
-        for (int xx = x; xx < width + x; xx++) {
-            offset = yOffset + xx;
-            dst[offset] = src[offset];
+    if (frameDeadlineSync) {
+        // A deadline that has already passed was missed by the caller, not
+        // the decoder, so start the timeline again from now
+        if (early < 0) {
+            frameDeadline = now;
+            early = 0;
         }
+        frameDeadlineSync = false;
     }
+
+    // Use the time before the frame is due to read ahead the next file
+    if (early > 0) {
+        gifPrefetchStep(frameDeadline);
+        early = (long) (frameDeadline - millis());
+    }
+
+    if (early > 0) {
+        delay(early);
+    }
+    else if (early < 0) {
+        lateFrameCount++;
+        lateFrameTime -= early;
+    }
+    matrix.swapBuffers();
+
+    frameDeadline += delayTime;
+}
+
+// Keep the frame on the display for longer instead of showing a frame that
+// is the same as it
+//   delayTime how long the skipped frame was to be shown in ms
+void extendFrame(int delayTime) {
+
+    frameDeadline += delayTime;
+    skippedFrameCount++;
+}
+
+// Report frames that missed their deadlines and frames that were skipped
+void frameSchedulerReport() {
+
+    Serial.print("Late frames: ");
+    Serial.print(lateFrameCount);
+    Serial.print(" Drift: ");
+    Serial.print(lateFrameTime);
+    Serial.print(" ms Skipped frames: ");
+    Serial.println(skippedFrameCount);
 }
 
 // Make sure the file is a Gif file
-boolean parseGifHeader() {
+boolean GifDecoder::parseGifHeader() {
 
     char buffer[10];
 
@@ -196,7 +319,7 @@ boolean parseGifHeader() {
 }
 
 // Parse the logical screen descriptor
-void parseLogicalScreenDescriptor() {
+void GifDecoder::parseLogicalScreenDescriptor() {
 
     lsdWidth = readWord();
     lsdHeight = readWord();
@@ -219,7 +342,7 @@ void parseLogicalScreenDescriptor() {
 }
 
 // Parse the global color table
-void parseGlobalColorTable() {
+void GifDecoder::parseGlobalColorTable() {
 
     // Does a global color table exist?
     if (lsdPackedField & COLORTBLFLAG) {
@@ -235,31 +358,28 @@ void parseGlobalColorTable() {
         // Read color values into the palette array
         int colorTableBytes = sizeof(RGB) * colorCount;
         readIntoBuffer(gifPalette, colorTableBytes);
+        colorLUTValid = false;
     }    
 }
 
 // Parse plain text extension and dispose of it
-void parsePlainTextExtension() {
+void GifDecoder::parsePlainTextExtension() {
 
 #if DEBUG == 1
     Serial.println("\nProcessing Plain Text Extension");
 #endif
     // Read plain text header length
-    byte len = readByte();
+    int len = readByte();
 
     // Consume plain text header data
     readIntoBuffer(tempBuffer, len);
 
     // Consume the plain text data in blocks
-    len = readByte();
-    while (len != 0) {
-        readIntoBuffer(tempBuffer, len);
-        len = readByte();
-    }
+    skipSubBlocks();
 }
 
 // Parse a graphic control extension
-void parseGraphicControlExtension() {
+void GifDecoder::parseGraphicControlExtension() {
 
 #if DEBUG == 1
     Serial.println("\nProcessing Graphic Control Extension");
@@ -267,6 +387,11 @@ void parseGraphicControlExtension() {
     int len = readByte();	// Check length
     if (len != 4) {
         Serial.println("Bad graphic control extension");
+
+        // Leave the frame attributes as they are and move past the extension
+        readIntoBuffer(tempBuffer, len);
+        skipSubBlocks();
+        return;
     }
 
     int packedBits = readByte();
@@ -298,7 +423,7 @@ void parseGraphicControlExtension() {
 }
 
 // Parse application extension
-void parseApplicationExtension() {
+void GifDecoder::parseApplicationExtension() {
 
     memset(tempBuffer, 0, sizeof(tempBuffer));
 
@@ -307,11 +432,13 @@ void parseApplicationExtension() {
 #endif
 
     // Read block length
-    byte len = readByte();
+    int len = readByte();
 
     // Read app data
     readIntoBuffer(tempBuffer, len);
 
+    boolean netscape = (strncmp(tempBuffer, "NETSCAPE2.0", 11) == 0);
+
 #if DEBUG == 1
     // Conditionally display the application extension string
     if (strlen(tempBuffer) != 0) {
@@ -322,22 +449,27 @@ void parseApplicationExtension() {
 
     // Consume any additional app data
     len = readByte();
-    while (len != 0) {
+    while (len > 0) {
         readIntoBuffer(tempBuffer, len);
+
+        // The Netscape extension holds the number of times to loop
+        if (netscape && (len == 3) && (tempBuffer[0] == 1)) {
+            loopCount = (byte) tempBuffer[1] | ((byte) tempBuffer[2] << 8);
+        }
         len = readByte();
     }
 }
 
 // Parse comment extension
-void parseCommentExtension() {
+void GifDecoder::parseCommentExtension() {
 
 #if DEBUG == 1
     Serial.println("\nProcessing Comment Extension");
 #endif
 
     // Read block length
-    byte len = readByte();
-    while (len != 0) {
+    int len = readByte();
+    while (len > 0) {
         // Clear buffer
         memset(tempBuffer, 0, sizeof(tempBuffer));
 
@@ -357,7 +489,7 @@ void parseCommentExtension() {
 }
 
 // Parse file terminator
-int parseGIFFileTerminator() {
+int GifDecoder::parseGIFFileTerminator() {
 
 #if DEBUG == 1
     Serial.println("\nProcessing file terminator");
@@ -378,8 +510,154 @@ int parseGIFFileTerminator() {
     }
 }
 
+// Record the area of the display covered by this frame
+// The area of the previous frame becomes the one its disposal method is
+// applied to
+void GifDecoder::setFrameRect(int x, int y, int width, int height) {
+
+    disposeMethod = prevDisposalMethod;
+    disposeX = rectX;
+    disposeY = rectY;
+    disposeWidth = rectWidth;
+    disposeHeight = rectHeight;
+
+    // Save disposal method and area of this frame for next time
+    prevDisposalMethod = disposalMethod;
+    rectX = x;
+    rectY = y;
+    rectWidth = width;
+    rectHeight = height;
+}
+
+// Apply the disposal method of the previous frame to the back buffer
+// Only the area of the previous frame is touched. It is cleared to black for
+// the background method or given back the pixels saved by saveScreenRect()
+void GifDecoder::disposeScreenRect() {
+
+    rgb24 *dst = matrix.backBuffer() + (disposeY * WIDTH) + disposeX;
+    int rowBytes = disposeWidth * sizeof(rgb24);
+
+    if (disposeMethod == DISPOSAL_BACKGROUND) {
+        for (int y = 0; y < disposeHeight; y++) {
+            memset(dst, 0, rowBytes);
+            dst += WIDTH;
+        }
+    }
+    else if (disposeMethod == DISPOSAL_RESTORE) {
+        rgb24 *src = screenBU;
+        for (int y = 0; y < disposeHeight; y++) {
+            memcpy(dst, src, rowBytes);
+            src += disposeWidth;
+            dst += WIDTH;
+        }
+    }
+}
+
+// Save the back buffer pixels under this frame if its disposal method
+// needs them restored before the next frame is drawn
+void GifDecoder::saveScreenRect() {
+
+    if (disposalMethod != DISPOSAL_RESTORE) {
+        return;
+    }
+    rgb24 *src = matrix.backBuffer() + (rectY * WIDTH) + rectX;
+    rgb24 *dst = screenBU;
+    int rowBytes = rectWidth * sizeof(rgb24);
+
+    for (int y = 0; y < rectHeight; y++) {
+        memcpy(dst, src, rowBytes);
+        src += WIDTH;
+        dst += rectWidth;
+    }
+}
+
+// Record the area of the display covered by an unscaled frame
+// The disposal of the previous frame is done when this one is drawn
+void GifDecoder::disposeFrame() {
+
+    keyFrame = false;
+
+    int x = min(tbiImageX, WIDTH);
+    int y = min(tbiImageY, HEIGHT);
+    setFrameRect(x, y, min(tbiImageX + tbiWidth, WIDTH) - x, min(tbiImageY + tbiHeight, HEIGHT) - y);
+}
+
+// Add bytes to the hash of the frame
+void GifDecoder::hashBytes(const byte *bytes, int count) {
+
+    uint32_t hash = frameHash;
+    while (count--) {
+        hash = (hash ^ *bytes++) * FRAME_HASH_PRIME;
+    }
+    frameHash = hash;
+}
+
+// Start the hash of the frame with the attributes and the local color table
+// that decide where and how its image data is drawn
+void GifDecoder::hashFrameStart() {
+
+    int attributes[] = {
+        tbiImageX, tbiImageY, tbiWidth, tbiHeight, tbiPackedBits,
+        transparentColorIndex, lzwCodeSize
+    };
+    frameHash = FRAME_HASH_SEED;
+    hashBytes((byte *) attributes, sizeof(attributes));
+    if (newPalette) {
+        hashBytes((byte *) gifPalette, sizeof(RGB) * colorCount);
+    }
+
+    firstBlockHash = frameHash;
+    frameBytes = 0;
+    firstBlock = true;
+}
+
+// Determine if the frame is the same as the previous one by hashing its
+// image data ahead of decoding it
+// Returns true with the image data consumed if it is. Otherwise the file is
+// left positioned where the decoder needs it
+boolean GifDecoder::checkFrameRepeated() {
+
+    // Only a frame drawn straight over the previous frame's pixels, and
+    // which doesn't need them saved, can be left out
+    if ((! prevFrameHashValid) ||
+        ((disposeMethod != DISPOSAL_NONE) && (disposeMethod != DISPOSAL_LEAVE)) ||
+        (disposalMethod == DISPOSAL_RESTORE)) {
+        return false;
+    }
+    // Most frames differ within their first sub-block, which the decoder
+    // then starts from
+    if ((! lzw_fill_window()) || (firstBlockHash != prevFirstBlockHash)) {
+        return false;
+    }
+    uint32_t position = getPosition();
+    uint32_t hash = frameHash;
+    uint32_t bytes = frameBytes;
+
+    // Hash the rest of the sub-blocks
+    int len = readByte();
+    while (len > 0) {
+        byte blockSize = len;
+        hashBytes(&blockSize, 1);
+        readIntoBuffer(tempBuffer, len);
+        hashBytes((byte *) tempBuffer, len);
+        frameBytes += len;
+        len = readByte();
+    }
+    if ((frameHash == prevFrameHash) && (frameBytes == prevFrameBytes)) {
+        lzwDataEnd = true;
+        return true;
+    }
+
+    // Unread the sub-blocks after the first one for the decoder
+    backUpStream(getPosition() - position);
+    frameHash = hash;
+    frameBytes = bytes;
+    return false;
+}
+
 // Parse table based image data
-void parseTableBasedImage() {
+// Returns ERROR_NONE or an error code if the frame can't be decoded
+int GifDecoder::parseTableBasedImage() {
 
 #if DEBUG == 1
     Serial.println("\nProcessing Table Based Image Descriptor");
@@ -392,6 +670,12 @@ void parseTableBasedImage() {
     tbiHeight = readWord();
     tbiPackedBits = readByte();
 
+    // Only the end of the file reads as a negative value
+    if (tbiPackedBits < 0) {
+        Serial.println("Bad GIF file format - Truncated image descriptor");
+        return ERROR_BADGIFFORMAT;
+    }
+
 #if DEBUG == 1
     Serial.print("tbiImageX: ");
     Serial.println(tbiImageX);
@@ -414,9 +698,9 @@ void parseTableBasedImage() {
 #endif
 
     // Does this image have a local color table ?
-    boolean localColorTable =  ((tbiPackedBits & COLORTBLFLAG) != 0);
+    newPalette = ((tbiPackedBits & COLORTBLFLAG) != 0);
 
-    if (localColorTable) {
+    if (newPalette) {
         int colorBits = ((tbiPackedBits & 7) + 1);
         colorCount = 1 << colorBits;
 
@@ -428,118 +712,178 @@ void parseTableBasedImage() {
         // Read colors into palette
         int colorTableBytes = sizeof(RGB) * colorCount;
         readIntoBuffer(gifPalette, colorTableBytes);
-    }
-
-    // One time initialization of imageData before first frame
-    if (keyFrame) {
-        if (transparentColorIndex == NO_TRANSPARENT_INDEX) {
-            fillImageData(lsdBackgroundIndex);
-        }    
-        else    {
-            fillImageData(transparentColorIndex);
-        }
-        keyFrame = false;
-
-        rectX = 0;
-        rectY = 0;
-        rectWidth = WIDTH;
-        rectHeight = HEIGHT;
-    }
-    // Don't clear matrix screen for these disposal methods
-    if ((prevDisposalMethod != DISPOSAL_NONE) && (prevDisposalMethod != DISPOSAL_LEAVE)) {
-        matrix.fillScreen({
-            0,0,0        }
-        );
-    }
-
-    // Process previous disposal method
-    if (prevDisposalMethod == DISPOSAL_BACKGROUND) {
-        // Fill portion of imageData with previous background color
-        fillImageDataRect(prevBackgroundIndex, rectX, rectY, rectWidth, rectHeight);
-    }    
-    else if (prevDisposalMethod == DISPOSAL_RESTORE) {
-        copyImageDataRect(imageDataBU, imageData, rectX, rectY, rectWidth, rectHeight);
-    }
-
-    // Save disposal method for this frame for next time
-    prevDisposalMethod = disposalMethod;
-
-    if (disposalMethod != DISPOSAL_NONE) {
-        // Save dimensions of this frame
-        rectX = tbiImageX;
-        rectY = tbiImageY;
-        rectWidth = tbiWidth;
-        rectHeight = tbiHeight;
-
-        if (disposalMethod == DISPOSAL_BACKGROUND) {
-            if (transparentColorIndex != NO_TRANSPARENT_INDEX) {
-                prevBackgroundIndex = transparentColorIndex;
-            }    
-            else    {
-                prevBackgroundIndex = lsdBackgroundIndex;   
-            }
-        }    
-        else if (disposalMethod == DISPOSAL_RESTORE) {
-            copyImageDataRect(imageData, imageDataBU, rectX, rectY, rectWidth, rectHeight);
-        }
+        colorLUTValid = false;
+        paletteChanged = true;
     }
 
     // Read the min LZW code size
+    // Larger code sizes would overrun the string table
     lzwCodeSize = readByte();
+    if ((lzwCodeSize < 1) || (lzwCodeSize > 8)) {
+        Serial.println("Bad GIF file format - Bad LZW code size");
+        return ERROR_BADGIFFORMAT;
+    }
 
 #if DEBUG == 1
     Serial.print("LzwCodeSize: ");
     Serial.println(lzwCodeSize);
 #endif
 
-    // Gather the lzw image data
-    // NOTE: the dataBlockSize byte is left in the data as the lzw decoder needs it
-    int offset = 0;
-    int dataBlockSize = readByte();
-    while (dataBlockSize != 0) {
-        backUpStream(1);
-        dataBlockSize++;
-        readIntoBuffer(lzwImageData + offset, dataBlockSize);
-        offset += dataBlockSize;
-        dataBlockSize = readByte();
+    // Only the frame attributes are wanted when scanning
+    if (scanning) {
+        skipSubBlocks();
+        return ERROR_NONE;
+    }
+
+    // Only one decoder at a time can keep the pixels under its frame
+    if (disposalMethod == DISPOSAL_RESTORE) {
+        if ((screenBUOwner != NULL) && (screenBUOwner != this)) {
+            Serial.println("Restore buffer in use by another decoder");
+            return ERROR_RESTOREBUSY;
+        }
+        screenBUOwner = this;
+    }
+
+    // Record the area of the frame and dispose of the previous one
+    if (scaled) {
+        disposeScaledFrame();
     }
+    else    {
+        disposeFrame();
+    }
+
+    stats.frames++;
+    stats.peakFrameSize = max(stats.peakFrameSize, (unsigned long) tbiWidth * tbiHeight);
+
     // Process the animation frame for display
 
     // Initialize the LZW decoder for this frame
-    lzw_decode_init(lzwCodeSize, lzwImageData);
+    // The decoder reads the image data sub-blocks directly from the file
+    lzw_decode_init(lzwCodeSize);
+
+    // A frame that is the same as the previous one is not decoded
+    hashFrameStart();
+    frameRepeated = checkFrameRepeated();
+
+    if (! frameRepeated) {
+        // Decompress LZW data into the image data buffer, or straight into the
+        // back buffer when the file is scaled down to fit the display
+        if (scaled) {
+            decompressScaledFrame();
+        }
+        else    {
+            decompressFrame();
+        }
+    }
 
-    // Decompress LZW data and display the frame
-    decompressAndDisplayFrame();
+    // Skip over any image data the decoder did not consume
+    lzw_decode_finish();
+
+    // The next frame is compared with this one
+    prevFrameHash = frameHash;
+    prevFirstBlockHash = firstBlockHash;
+    prevFrameBytes = frameBytes;
+    prevFrameHashValid = true;
 
     // Make sure there is at least some delay between frames
-    if (frameDelay < 6) {
-        frameDelay = 6;
+    if (frameDelay < MIN_FRAME_DELAY) {
+        frameDelay = MIN_FRAME_DELAY;
     }
-    delay(frameDelay * 10);
 
-    // Graphic control extension is for a single frame
-    // Remove its influence
+#if SD_STATS == 1
+    Serial.print("SD calls this frame: ");
+    Serial.println(stats.sdCalls - frameSdCalls);
+#endif
+    frameSdCalls = stats.sdCalls;
+
+    return ERROR_NONE;
+}
+
+// Open a gif file and parse everything up to its first frame
+int GifDecoder::open(const char *pathname) {
+
+    // Initialize variables
+    keyFrame = true;
+    prevDisposalMethod = DISPOSAL_NONE;
     transparentColorIndex = NO_TRANSPARENT_INDEX;
     disposalMethod = DISPOSAL_NONE;
+    colorLUTValid = false;
+    rowMapHeight = 0;
+    frameRepeated = false;
+    prevFrameHashValid = false;
+    loopCount = NO_LOOP_COUNT;
+    scanning = false;
+    paletteChanged = false;
+
+    file.close();
+
+    // Take the file over if it has been read ahead
+    int prefetched = gifPrefetchTake(pathname, file);
+    prefetchedSize = max(prefetched, 0);
+
+    // Read the file from the GIF pack of its directory if it is in one
+    source = (prefetched < 0) ? gifPackFind(pathname, &sourceBase, &sourceSize, &sourceBlock) : NULL;
+    if (source == NULL) {
+        // Attempt to open the file for reading
+        if ((prefetched < 0) && (! file.open(pathname))) {
+            Serial.println("Error opening GIF file");
+            return ERROR_FILEOPEN;
+        }
+        source = &file;
+        sourceBase = 0;
+        sourceSize = file.fileSize();
+        sourceBlock = 0;
+    }
+    resetReadBuffer(0);
+    memset(&stats, 0, sizeof(stats));
+    frameSdCalls = 0;
+
+    // Validate the header
+    if (! parseGifHeader()) {
+        Serial.println("Not a GIF file");
+        file.close();
+        return ERROR_FILENOTGIF;
+    }
+    // If we get here we have a gif file to process
+
+    // Parse the logical screen descriptor
+    parseLogicalScreenDescriptor();
+
+    // Parse the global color table
+    parseGlobalColorTable();
+
+    // Files larger than the display are scaled down as they are decoded
+    scaleBegin();
+
+    // Remember where the frames start so the file can be played again
+    firstFramePosition = getPosition();
+
+    return ERROR_NONE;
 }
 
-// Parse gif data
-unsigned long parseData(unsigned long (*checkForInput)()) {
+// Parse gif data up to and including the next frame
+// Returns FRAME_DECODED when a frame is ready to be drawn, ERROR_NONE at
+// the end of the file or an error code
+int GifDecoder::decodeFrame() {
 
 #if DEBUG == 1
     Serial.println("\nParsing Data Block");
 #endif
 
-    boolean done = false;	
-    while (! done) {
+    // Graphic control extension is for a single frame
+    // Remove the influence of the one for the previous frame
+    transparentColorIndex = NO_TRANSPARENT_INDEX;
+    disposalMethod = DISPOSAL_NONE;
+
+    while (true) {
 
         // Determine what kind of data to process
         byte b = readByte();
 
         if (b == 0x2c) {
             // Parse table based image
-            parseTableBasedImage();
-
+            int result = parseTableBasedImage();
+            return (result == ERROR_NONE) ? FRAME_DECODED : result;
         }	
         else if (b == 0x21) {
             // Parse extension
@@ -570,96 +914,303 @@ unsigned long parseData(unsigned long (*checkForInput)()) {
             }
         }	
         else	{
-            done = true;
-
             // Push unprocessed byte back into the stream for later processing
             backUpStream(1);
-        }
-        // Check to see if user wants to abort current animation
-        int input = checkForInput();
-        if((input == IRCODE_HOME) || (input == IRCODE_RIGHT) || (input == IRCODE_LEFT)) {
-            return input;
+
+            // Parse the gif file terminator
+            return parseGIFFileTerminator();
         }
     }
-    return ERROR_NONE;
 }
 
-// Attempt to parse the gif file
-unsigned long processGIFFile(const char *pathname, unsigned long (*checkForInput)()) {
+// Close the gif file
+void GifDecoder::close() {
 
-    // Initialize variables
-    keyFrame = true;
-    prevDisposalMethod = DISPOSAL_NONE;
-    transparentColorIndex = NO_TRANSPARENT_INDEX;
+    file.close();
+    prefetchedSize = 0;
 
-    Serial.print("Pathname: ");
-    Serial.println(pathname);
+    // Let other decoders have the restore buffer
+    if (screenBUOwner == this) {
+        screenBUOwner = NULL;
+    }
+}
 
-    file.close();
+// Get the file position of the next block to be parsed
+uint32_t GifDecoder::getPosition() {
+
+    return sourcePosition - (readBufferCount - readBufferIndex);
+}
+
+// Parse the next frame without decoding its image data
+// Returns FRAME_DECODED with the frame described in info, ERROR_NONE at
+// the end of the file or an error code
+int GifDecoder::scanFrame(GifFrameInfo *info) {
+
+    info->position = getPosition();
+    boolean firstFrame = keyFrame;
 
-    // Attempt to open the file for reading
-    if (! file.open(pathname)) {
-        Serial.println("Error opening GIF file");
-        return ERROR_FILEOPEN;
+    scanning = true;
+    int result = decodeFrame();
+    scanning = false;
+
+    if (result != FRAME_DECODED) {
+        return result;
     }
-    // Validate the header
-    if (! parseGifHeader()) {
-        Serial.println("Not a GIF file");
-        file.close();
-        return ERROR_FILENOTGIF;
+    keyFrame = false;
+
+    info->delay = max(frameDelay, MIN_FRAME_DELAY);
+    info->disposal = disposalMethod;
+    info->flags = 0;
+
+    // A frame that covers the display with opaque pixels, doesn't back up
+    // the image for the next frame and uses a palette it brings itself or
+    // the global one doesn't depend on the frames before it
+    int screenWidth = scaled ? lsdWidth : WIDTH;
+    int screenHeight = scaled ? lsdHeight : HEIGHT;
+
+    if (firstFrame ||
+        ((tbiImageX == 0) && (tbiImageY == 0) && (tbiWidth >= screenWidth) && (tbiHeight >= screenHeight) &&
+         (transparentColorIndex == NO_TRANSPARENT_INDEX) && (disposalMethod != DISPOSAL_RESTORE) &&
+         (newPalette || ! paletteChanged))) {
+        info->flags |= FRAME_KEY;
     }
-    // If we get here we have a gif file to process
+    return FRAME_DECODED;
+}
 
-    // Parse the logical screen descriptor
-    parseLogicalScreenDescriptor();
+// Position the decoder at a key frame found by scanFrame() or at the first
+// frame of the file
+//   position the file position of the frame
+int GifDecoder::seekFrame(uint32_t position) {
 
-    // Parse the global color table
-    parseGlobalColorTable();
+    keyFrame = true;
+    prevDisposalMethod = DISPOSAL_NONE;
+    transparentColorIndex = NO_TRANSPARENT_INDEX;
+    disposalMethod = DISPOSAL_NONE;
+    colorLUTValid = false;
+    frameRepeated = false;
+    prevFrameHashValid = false;
+
+    // Key frames may rely on the global color table so read it again if a
+    // local color table has replaced it
+    if (paletteChanged) {
+        resetReadBuffer(GIFGCTPOSITION);
+        parseGlobalColorTable();
+        paletteChanged = false;
+    }
 
-    // Parse gif data
-    unsigned long result = parseData(checkForInput);
-    if (result != ERROR_NONE) {
-        Serial.println("Error: ");
-        Serial.println(result);
-        Serial.println(" occurred during parsing of data");
-        file.close();
-        return result;
+    if (position > sourceSize) {
+        return ERROR_BADGIFFORMAT;
     }
-    // Parse the gif file terminator
-    result = parseGIFFileTerminator();
-    file.close();
+    resetReadBuffer(position);
 
-    Serial.println("Success");
-    return result;
+    return ERROR_NONE;
 }
 
+// Decode and display one loop of the open gif file
+// Returns an IR code if the user wants to abort the animation, ERROR_NONE at
+// the end of the loop or an error code
+unsigned long playGIFLoop(const char *pathname, unsigned long (*checkForInput)()) {
 
+    int result;
 
+    // Record the frames as they are displayed unless they are known not to fit
+    if (! frameCacheTooBig(pathname)) {
+        frameCacheBegin(pathname);
+    }
 
+    // Decode and display the frames one at a time
+    while ((result = gifDecoder.decodeFrame()) == FRAME_DECODED) {
+#if DRAW_STATS == 1
+        unsigned long drawStart = micros();
+        gifDecoder.drawFrame();
+        Serial.print("Draw time: ");
+        Serial.println(micros() - drawStart);
+#else
+        gifDecoder.drawFrame();
+#endif
 
+        // Save the frame so later loops can be replayed
+        frameCacheAddFrame(gifDecoder);
 
+        // Show the frame when it is due. A repeated frame keeps the one on
+        // the display there for longer
+        if (gifDecoder.getFrameRepeated()) {
+            extendFrame(gifDecoder.getFrameDelay() * 10);
+        }
+        else    {
+            presentFrame(gifDecoder.getFrameDelay() * 10);
+        }
 
+        // Check to see if user wants to abort current animation
+        unsigned long input = checkForInput();
+        if ((input == IRCODE_HOME) || (input == IRCODE_RIGHT) || (input == IRCODE_LEFT)) {
+            frameCacheEnd(false);
+            return input;
+        }
 
+        // Skip ahead to the next key frame if the user asks and the index of
+        // the file has one. The frames in between aren't recorded, so the
+        // loop isn't cached
+        GifFrameInfo info;
+        if ((input == IRCODE_DOWN) &&
+            frameIndexFindNextKeyFrame(pathname, gifDecoder.getPosition(), &info) &&
+            (gifDecoder.seekFrame(info.position) == ERROR_NONE)) {
+            frameCacheEnd(false);
+        }
+    }
+    frameCacheEnd(result == ERROR_NONE);
 
+    if (result != ERROR_NONE) {
+        Serial.print("Error: ");
+        Serial.print(result);
+        Serial.println(" occurred during parsing of data");
+    }
+    return result;
+}
 
+// Play a gif file
+//   playTime how long to play the file in ms. The file is played in whole
+//   loops, as many as come closest to the play time when the length of a
+//   loop is known. GIF_PLAY_ONCE plays a single loop and GIF_PLAY_FOREVER
+//   loops until the user aborts. A file with a finite Netscape loop count is
+//   not played more times than it asks for
+// The file is opened once and played again by seeking back to its first
+// frame, or from the frame cache once that holds it
+// Returns an IR code if the user wants to abort the animation
+unsigned long processGIFFile(const char *pathname, unsigned long (*checkForInput)(), unsigned long playTime) {
 
+    Serial.print("Pathname: ");
+    Serial.println(pathname);
 
+    unsigned long startTime = millis();
 
+    // Work out how many loops to play, 0 if it depends on the play time
+    int loopCount = NO_LOOP_COUNT;
+    int loopsLeft = (playTime == GIF_PLAY_ONCE) ? 1 : 0;
+    unsigned long loopTime = 0;
 
+    // Building the index of the file leaves it open, so a file that was read
+    // ahead keeps the handle and data read for it
+    boolean fileOpen = false;
 
+    if ((playTime != GIF_PLAY_ONCE) && frameIndexLoad(gifDecoder, pathname, &fileOpen)) {
+        loopCount = frameIndexLoopCount();
 
+        loopTime = frameIndexDuration();
+        if ((playTime != GIF_PLAY_FOREVER) && (loopTime != 0)) {
+            loopsLeft = max((int) ((playTime + (loopTime / 2)) / loopTime), 1);
+        }
+    }
 
+    // Work out when the file is expected to end so the next one can be read
+    // ahead before then
+    unsigned long playLength = playTime;
+    if ((loopsLeft != 0) && (loopTime != 0)) {
+        int loops = ((loopCount > 0) && (loopCount < loopsLeft)) ? loopCount + 1 : loopsLeft;
+        playLength = loops * loopTime;
+    }
 
+    // Keep to the timeline of the previous call if this is another loop, or
+    // if this file was read ahead to follow straight on from the previous one
+    frameSchedulerStart((strcmp(pathname, prevPathname) == 0) || gifPrefetchReady(pathname));
+    strncpy(prevPathname, pathname, sizeof(prevPathname) - 1);
 
+    unsigned long result;
+    int loopsPlayed = 0;
 
+    while (true) {
+        boolean cached = frameCacheHolds(pathname);
+        if (cached) {
+            gifDecoder.close();
+            fileOpen = false;
+        }
+        else    {
+            // Open the file the first time and go back to its first frame after that
+            result = fileOpen ? gifDecoder.rewind() : gifDecoder.open(pathname);
+            if (result != ERROR_NONE) {
+                break;
+            }
+            fileOpen = true;
+        }
 
+        // Start reading ahead the next file once this one is under way
+        if (loopsPlayed == 0) {
+            gifPrefetchSchedule(playTime != GIF_PLAY_FOREVER, startTime + playLength);
+        }
 
+        if (cached) {
+            // Replay the animation from the frame cache
+            result = frameCachePlay(checkForInput);
+        }
+        else    {
+            result = playGIFLoop(pathname, checkForInput);
 
+            // The Netscape looping extension comes before the first frame
+            loopCount = gifDecoder.getLoopCount();
 
+            // A file without frames would loop without ever checking for input
+            if (gifDecoder.getStats().frames == 0) {
+                break;
+            }
+        }
+        loopsPlayed++;
 
+        if (result != ERROR_NONE) {
+            break;
+        }
+        // A loop count of n asks for the animation to be repeated n times
+        if ((loopCount > 0) && (loopsPlayed > loopCount)) {
+            break;
+        }
+        if (loopsLeft != 0) {
+            if (loopsPlayed >= loopsLeft) {
+                break;
+            }
+        }
+        else if ((playTime != GIF_PLAY_FOREVER) && ((millis() - startTime) >= playTime)) {
+            break;
+        }
+    }
+    gifDecoder.close();
 
+    if (result == ERROR_NONE) {
+        frameSchedulerReport();
+        Serial.println("Success");
+    }
+    return result;
+}
 
+// Show the frame from the middle of a gif file as a preview of it
+// Only the frames from the key frame before it are decoded
+// Returns false if the file can't be previewed
+boolean showGIFPreview(const char *pathname) {
 
+    GifFrameInfo info;
 
+    if (! frameIndexLoad(gifDecoder, pathname, NULL)) {
+        return false;
+    }
+    int frameNumber = frameIndexFrameCount() / 2;
+    int keyFrameNumber = frameIndexFindKeyFrame(frameNumber, &info);
 
+    if ((gifDecoder.open(pathname) != ERROR_NONE) ||
+        (gifDecoder.seekFrame(info.position) != ERROR_NONE)) {
+        gifDecoder.close();
+        return false;
+    }
+    matrix.fillScreen({
+        0,0,0        }
+    );
+
+    // Draw the frames up to the preview frame without showing them
+    for (int i = keyFrameNumber; i <= frameNumber; i++) {
+        if (gifDecoder.decodeFrame() != FRAME_DECODED) {
+            break;
+        }
+        gifDecoder.drawFrame();
+    }
+    gifDecoder.close();
 
+    matrix.swapBuffers();
+    return true;
+}
@@ -0,0 +1,241 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to read ahead the animated GIF file that is to be
+ * played next. While the last seconds of an animation play, the next file
+ * is opened, its start read through the end of its first frame and its frame
+ * index loaded a step at a time in the idle time before each frame is due,
+ * so the next animation can start on the following frame deadline
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "GifDecoder.h"
+
+#include <SdFat.h>
+extern SdFat sd;
+
+// Defined in GIFPackFunctions.cpp
+extern boolean gifPackDirEntry(const char *pathname, dir_t *entry);
+
+// Defined in FrameIndexFunctions.cpp
+extern boolean frameIndexLoadExisting(const char *pathname, dir_t *gifEntry);
+
+// Prefetch steps, one is taken in each idle time that is long enough
+#define PREFETCH_IDLE  0    // Nothing to read ahead
+#define PREFETCH_OPEN  1    // Open the file
+#define PREFETCH_READ  2    // Read it up to the end of its first frame
+#define PREFETCH_INDEX 3    // Load its frame index
+#define PREFETCH_DONE  4    // Ready to be played
+
+// Reading ahead starts this long before the current animation ends, in ms
+#define PREFETCH_LEAD_TIME 3000
+
+// Steps are only taken when the next frame is due at least this far ahead, in ms
+#define PREFETCH_MIN_IDLE  15
+
+// Most of the start of a file that is read ahead, a whole number of blocks.
+// Enough for the header, a full global color table and the first frame of
+// most 32x32 animations
+#define PREFETCH_BUFFER_SIZE (3 * READ_BUFFER_SIZE)
+
+int prefetchState = PREFETCH_IDLE;
+char prefetchPathname[50];
+unsigned long prefetchStartTime;
+
+// Pathname of the file to read ahead once the current one is playing
+char prefetchNextPathname[50];
+
+SdFile prefetchFile;
+dir_t prefetchEntry;
+
+// Start of the file
+// It stays valid for the decoder that took the file over until reading
+// ahead the file after it begins
+byte prefetchBuffer[PREFETCH_BUFFER_SIZE];
+int prefetchCount;
+boolean prefetchTaken;
+
+// Name the file to be read ahead while the next file to be played plays
+void gifPrefetchBegin(const char *pathname) {
+
+    strncpy(prefetchNextPathname, pathname, sizeof(prefetchNextPathname) - 1);
+    prefetchNextPathname[sizeof(prefetchNextPathname) - 1] = '\0';
+}
+
+// Drop the file read ahead, if any, and start reading ahead the file named
+// by gifPrefetchBegin()
+// Called once the file being played is under way
+//   enabled false if the current file plays until the user moves on
+//   endTime the time at which the current file is expected to end
+void gifPrefetchSchedule(boolean enabled, unsigned long endTime) {
+
+    prefetchFile.close();
+    prefetchState = PREFETCH_IDLE;
+
+    if (enabled && (prefetchNextPathname[0] != '\0')) {
+        strcpy(prefetchPathname, prefetchNextPathname);
+        prefetchStartTime = endTime - PREFETCH_LEAD_TIME;
+        prefetchState = PREFETCH_OPEN;
+    }
+    prefetchNextPathname[0] = '\0';
+}
+
+// Find the end of the first frame in the data read ahead
+// Returns its offset or 0 if the data doesn't reach that far yet
+int prefetchFirstFrameEnd() {
+
+    // Header and logical screen descriptor, then the global color table
+    int i = 13;
+    if (prefetchCount < i) {
+        return 0;
+    }
+    if (prefetchBuffer[10] & 0x80) {
+        i += 3 << ((prefetchBuffer[10] & 0x07) + 1);
+    }
+
+    while (i < prefetchCount) {
+        byte b = prefetchBuffer[i];
+        if (b == 0x2c) {
+            // Image descriptor, local color table and LZW code size
+            if (i + 10 > prefetchCount) {
+                return 0;
+            }
+            byte packed = prefetchBuffer[i + 9];
+            i += 10;
+            if (packed & 0x80) {
+                i += 3 << ((packed & 0x07) + 1);
+            }
+            i++;
+        }
+        else if (b == 0x21) {
+            // Extension introducer and label
+            i += 2;
+        }
+        else    {
+            // Nothing the first frame is made of follows
+            return i;
+        }
+
+        // Data sub-blocks up to the block terminator
+        while ((i < prefetchCount) && (prefetchBuffer[i] != 0)) {
+            i += prefetchBuffer[i] + 1;
+        }
+        if (i >= prefetchCount) {
+            return 0;
+        }
+        i++;
+        if (b == 0x2c) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Take a step of reading ahead if there is time for it
+//   deadline the time at which the next frame is due
+void gifPrefetchStep(unsigned long deadline) {
+
+    if ((prefetchState == PREFETCH_IDLE) || (prefetchState == PREFETCH_DONE)) {
+        return;
+    }
+    unsigned long now = millis();
+    if (((long) (now - prefetchStartTime) < 0) || ((long) (deadline - now) < PREFETCH_MIN_IDLE)) {
+        return;
+    }
+
+    switch (prefetchState) {
+    case PREFETCH_OPEN:
+        // The start of the file before is given up
+        prefetchTaken = false;
+        prefetchCount = 0;
+
+        // A file in a GIF pack has nothing to open
+        if (gifPackDirEntry(prefetchPathname, &prefetchEntry)) {
+            prefetchState = PREFETCH_INDEX;
+        }
+        else if (prefetchFile.open(prefetchPathname, O_READ) && prefetchFile.dirEntry(&prefetchEntry)) {
+            prefetchState = PREFETCH_READ;
+        }
+        else    {
+            prefetchFile.close();
+            prefetchState = PREFETCH_IDLE;
+        }
+        break;
+
+    case PREFETCH_READ:
+        // A block is read at each step until the first frame is in
+        {
+            int count = prefetchFile.read(prefetchBuffer + prefetchCount, READ_BUFFER_SIZE);
+            prefetchCount += max(count, 0);
+            if ((count < READ_BUFFER_SIZE) || (prefetchCount == PREFETCH_BUFFER_SIZE) ||
+                (prefetchFirstFrameEnd() != 0)) {
+                prefetchState = PREFETCH_INDEX;
+            }
+        }
+        break;
+
+    case PREFETCH_INDEX:
+        frameIndexLoadExisting(prefetchPathname, &prefetchEntry);
+        prefetchState = PREFETCH_DONE;
+        break;
+    }
+}
+
+// True if the specified file has been read ahead
+boolean gifPrefetchReady(const char *pathname) {
+
+    return (prefetchState == PREFETCH_DONE) && (strcmp(pathname, prefetchPathname) == 0);
+}
+
+// Take over the file read ahead if it is the specified file
+//   file set to the open file
+// Returns the number of bytes read from the start of the file, which
+// gifPrefetchRead() returns, or -1 if the file is not open
+int gifPrefetchTake(const char *pathname, SdFile &file) {
+
+    if ((prefetchState <= PREFETCH_OPEN) || (! prefetchFile.isOpen()) ||
+        (strcmp(pathname, prefetchPathname) != 0)) {
+        return -1;
+    }
+    file = prefetchFile;
+    prefetchFile.close();
+    prefetchState = PREFETCH_IDLE;
+    prefetchTaken = true;
+
+    return prefetchCount;
+}
+
+// Copy data read from the start of the file taken over by gifPrefetchTake()
+//   position the position in the file of the data
+//   count the most bytes to copy
+// Returns the number of bytes copied, 0 once reading ahead the next file
+// has started
+int gifPrefetchRead(uint32_t position, byte *buffer, int count) {
+
+    if ((! prefetchTaken) || (position >= (uint32_t) prefetchCount)) {
+        return 0;
+    }
+    count = min(count, prefetchCount - (int) position);
+    memcpy(buffer, prefetchBuffer + position, count);
+    return count;
+}
@@ -0,0 +1,352 @@
+#ifndef GifDecoder_H
+#define GifDecoder_H
+
+#include "SmartMatrix_32x32.h"
+#include "SdFat.h"
+
+// Error codes
+#define ERROR_NONE		    0
+#define ERROR_FILEOPEN		   -1
+#define ERROR_FILENOTGIF	   -2
+#define ERROR_BADGIFFORMAT         -3
+#define ERROR_UNKNOWNCONTROLEXT	   -4
+#define ERROR_RESTOREBUSY          -5
+
+// Returned by decodeFrame() when a frame is ready to be drawn
+#define FRAME_DECODED               1
+
+#define NO_TRANSPARENT_INDEX -1
+
+// Disposal methods
+#define DISPOSAL_NONE       0
+#define DISPOSAL_LEAVE      1
+#define DISPOSAL_BACKGROUND 2
+#define DISPOSAL_RESTORE    3
+
+// Loop count of a file without a Netscape looping extension
+#define NO_LOOP_COUNT -1
+
+// Play times for processGIFFile()
+#define GIF_PLAY_ONCE    0
+#define GIF_PLAY_FOREVER 0xFFFFFFFF
+
+// Color lookup table entry of the transparent color index
+// Never matches a real color as those are packed into the low 24 bits
+#define LUT_TRANSPARENT 0xFFFFFFFF
+
+// LZW constants
+// The full 12 bit GIF code space is supported
+#define LZW_MAXBITS    12
+#define LZW_SIZTABLE  (1 << LZW_MAXBITS)
+#define LZW_LONG_STRING 255     // Length table entry of a string this long or longer
+
+// Size of the read ahead buffer, one SD card sector
+#define READ_BUFFER_SIZE 512
+
+// RAM of the frame cache in bytes. 1152 of them hold what is on the screen
+// while a file is recorded, the rest the frames. The cache shares its RAM with
+// the games, so up to the size of the largest game it costs no RAM of its own.
+// Set to 0 to stream every loop of a file from the SD card
+#ifndef FRAME_CACHE_SIZE
+#define FRAME_CACHE_SIZE 7168
+#endif
+
+// FNV-1a hash used to recognize repeated frames
+#define FRAME_HASH_SEED  2166136261UL
+#define FRAME_HASH_PRIME 16777619UL
+
+// RGB data structure
+typedef struct {
+    byte Red;
+    byte Green;
+    byte Blue;
+}
+RGB;
+
+// Frame flags
+#define FRAME_KEY 0x01      // Frame can be decoded without the frames before it
+
+// Description of a frame found by scanFrame()
+typedef struct {
+    uint32_t position;      // File position of the blocks of the frame
+    uint16_t delay;         // Frame delay in 1/100 s
+    byte disposal;          // Disposal method
+    byte flags;             // Frame flags
+}
+GifFrameInfo;
+
+// Decoding statistics of a file, counted from when it is opened
+typedef struct {
+    unsigned long frames;           // Frames decoded
+    unsigned long lzwCodes;         // LZW codes decoded
+    unsigned long bytesRead;        // Bytes read from the SD card
+    unsigned long sdCalls;          // Read and seek calls made to the SD card
+    int peakTableSize;              // Most LZW string table entries in use
+    unsigned long peakFrameSize;    // Largest frame in pixels
+}
+GifDecoderStats;
+
+// Decodes an animated GIF file one frame at a time
+// Every instance has its own file, palette and image buffers, about 4.3 KB,
+// so a second file can be opened and decoded next to the one playing. The
+// LZW string table and the downscaling sums are shared because a frame is
+// always decoded completely within one call to decodeFrame(). The pixels
+// saved for disposal method 3 are shared too, so only one of the files can
+// use that disposal method at a time
+class GifDecoder {
+private:
+    SdFile file;
+
+    // File the GIF data is read from, either file or a GIF pack holding the
+    // GIF file among others. All positions are relative to the start of the
+    // GIF data
+    SdBaseFile *source;
+    uint32_t sourceBase;        // Position of the GIF data in the source
+    uint32_t sourceSize;        // Size of the GIF data
+    uint32_t sourceBlock;       // First SD card block of a contiguous source or 0
+    uint32_t sourcePosition;    // Position of the end of the read buffer
+    uint32_t prefetchedSize;    // Bytes at the start of the file read ahead
+
+    // Read ahead buffer
+    // The file is read from the SD card a sector at a time into this buffer
+    // and all of the parse functions take their bytes from here
+    byte readBuffer[READ_BUFFER_SIZE];
+    int readBufferIndex;    // Index of next byte to return from the buffer
+    int readBufferCount;    // Number of valid bytes in the buffer
+
+    // Decoding statistics
+    GifDecoderStats stats;
+    unsigned long frameSdCalls; // SD card calls made before this frame
+
+    // Logical screen descriptor attributes
+    int lsdWidth;
+    int lsdHeight;
+    int lsdPackedField;
+    int lsdAspectRatio;
+    int lsdBackgroundIndex;
+
+    // Table based image attributes
+    int tbiImageX;
+    int tbiImageY;
+    int tbiWidth;
+    int tbiHeight;
+    int tbiPackedBits;
+    boolean tbiInterlaced;
+
+    int frameDelay;
+    int transparentColorIndex;
+    int prevDisposalMethod;
+    int disposalMethod;
+    int lzwCodeSize;
+    boolean keyFrame;
+    boolean newPalette;     // Frame brought its own color table
+
+    // Area of the display covered by the previous frame
+    int rectX;
+    int rectY;
+    int rectWidth;
+    int rectHeight;
+
+    // Area of the display the disposal method of the previous frame is
+    // applied to before this frame is drawn
+    int disposeMethod;
+    int disposeX;
+    int disposeY;
+    int disposeWidth;
+    int disposeHeight;
+
+    int loopCount;
+    uint32_t firstFramePosition;
+    boolean scanning;       // Frames are being scanned rather than decoded
+    boolean frameRepeated;  // Frame is the same as the previous one
+    boolean paletteChanged; // A frame has replaced the global color table
+
+    int colorCount;
+    RGB gifPalette[256];
+
+    // Palette expanded for drawing as 0x00RRGGBB with the transparent color
+    // index set to LUT_TRANSPARENT
+    uint32_t colorLUT[256];
+    boolean colorLUTValid;      // Cleared whenever a color table is read
+    int colorLUTTransparentIndex;
+
+    char tempBuffer[260];
+
+    // Buffer image data is decoded into
+    byte imageData[1024];
+
+    // Frame row each decoded row of a frame is written to, in the order the
+    // rows are stored in the file. Built for frames of rowMapHeight rows
+    byte rowMap[32];
+    int rowMapHeight;
+    boolean rowMapInterlaced;
+
+    // Downscaling of files larger than the display
+    // Each display pixel is the average of the file pixels that fall in it.
+    // Sums are kept for one display row at a time. A 65535 pixel square
+    // logical screen puts over 4 million file pixels in a display pixel, so
+    // the counts need 32 bits as well
+    boolean scaled;
+    int scaleX0;                // Display position of the scaled logical screen
+    int scaleY0;
+    int scaleWidth;             // Size of the scaled logical screen
+    int scaleHeight;
+    int scaleRow;               // Display row being summed or -1
+    int scaleRowHeight;         // Number of file rows summed into it
+    static uint32_t scaleRed[32];
+    static uint32_t scaleGreen[32];
+    static uint32_t scaleBlue[32];
+    static uint32_t scaleOpaque[32];    // Number of opaque pixels summed
+
+    // Repeated frame detection
+    // The image descriptor, the LZW code size and the image data sub-blocks
+    // of each frame are hashed as they are read. A frame whose hash matches
+    // the previous frame's would draw the same pixels over them again. The
+    // number of image data bytes must match as well, so a hash collision
+    // alone doesn't drop a frame
+    uint32_t frameHash;
+    uint32_t firstBlockHash;    // Hash up to the end of the first sub-block
+    uint32_t frameBytes;        // Image data bytes hashed
+    boolean firstBlock;         // First sub-block is yet to be read
+    uint32_t prevFrameHash;
+    uint32_t prevFirstBlockHash;
+    uint32_t prevFrameBytes;
+    boolean prevFrameHashValid;
+
+    // LZW input window
+    // Holds one data sub-block of the frame at a time as it is read from the file
+    byte lzwBlock[255];
+    byte *pbuf;                 // Next byte in the window
+    int bs;                     // Bytes remaining in the window
+    boolean lzwDataEnd;         // Set when the block terminator has been read
+
+    // LZW variables
+    int bbits;
+    int bbuf;
+    int cursize;                // The current code size
+    int curmask;
+    int codesize;
+    int clear_code;
+    int end_code;
+    int newcodes;               // First available code
+    int top_slot;               // Highest code for current size
+    int slot;                   // Next code to be added to the table
+    int oc;                     // Previous code
+    int ocLength;               // Length of the string for oc
+    byte ocFirst;               // First char of the string for oc
+    int pendCode;               // String only partially output by last call
+    int pendCount;              // Number of chars of pendCode still to be output
+
+    // Masks for 0 .. 16 bits
+    static const unsigned int mask[17];
+
+    // String table
+    // Every string is its prefix string plus one suffix char. A string is
+    // written by walking its prefixes from the last char to the first, filling
+    // the output from back to front, so no reversing stack is needed. The
+    // length of each string is kept so it can be written in that one walk.
+    // Its first char is the one the walk ends on. Lengths of LZW_LONG_STRING
+    // and more, which are rare, are found by walking the string first
+    static uint16_t prefix[LZW_SIZTABLE];
+    static byte suffix[LZW_SIZTABLE];
+    static byte length[LZW_SIZTABLE];
+
+    // Back buffer pixels under a frame with disposal method == 3, stored
+    // row after row for the width of the frame, and the decoder that owns
+    // them. The first decoder to draw such a frame owns the buffer until it
+    // is closed. Another decoder meeting such a frame meanwhile stops with
+    // ERROR_RESTOREBUSY
+    static rgb24 screenBU[1024];
+    static GifDecoder *screenBUOwner;
+
+    // Read buffer functions in GIFParseFunctions.cpp
+    void resetReadBuffer(uint32_t position);
+    boolean fillReadBuffer();
+    void backUpStream(int n);
+    int readByte();
+    int readWord();
+    int readIntoBuffer(void *buffer, int numberOfBytes);
+    void skipSubBlocks();
+
+    // Parse functions in GIFParseFunctions.cpp
+    boolean parseGifHeader();
+    void parseLogicalScreenDescriptor();
+    void parseGlobalColorTable();
+    void parsePlainTextExtension();
+    void parseGraphicControlExtension();
+    void parseApplicationExtension();
+    void parseCommentExtension();
+    int parseGIFFileTerminator();
+    void setFrameRect(int x, int y, int width, int height);
+    void disposeScreenRect();
+    void saveScreenRect();
+    void disposeFrame();
+    void hashBytes(const byte *bytes, int count);
+    void hashFrameStart();
+    boolean checkFrameRepeated();
+    int parseTableBasedImage();
+
+    // LZW functions in LZWFunctions.cpp
+    void lzw_decode_init(int csize);
+    boolean lzw_fill_window();
+    void lzw_decode_finish();
+    int lzw_get_code();
+    void lzw_copy_string(int code, int skip, int count, byte *buf);
+    int lzw_string_length(int code);
+    void lzw_add_string(int pc, byte c, int n);
+    int lzw_decode(byte *buf, int len);
+    void buildRowMap(int height);
+    void decompressFrame();
+    void decompressClippedFrame();
+
+    // Scaling functions in LZWFunctions.cpp
+    void scaleBegin();
+    int scaleX(int x);
+    int scaleY(int y);
+    void scaleAccumulate(byte *src, int x, int count);
+    void scaleResolveRow();
+    void decompressScaledFrame();
+    void disposeScaledFrame();
+    void updateColorLUT();
+
+public:
+    int open(const char *pathname);
+    int decodeFrame();
+    void drawFrame();
+    void close();
+
+    // Frame index support
+    int scanFrame(GifFrameInfo *info);
+    int seekFrame(uint32_t position);
+    int rewind() { return seekFrame(firstFramePosition); }
+    uint32_t getPosition();
+    int getLoopCount() { return loopCount; }
+    const GifDecoderStats &getStats() { return stats; }
+
+    // True if the file is scaled down to fit the display. Scaled frames are
+    // drawn as they are decoded and have no image data
+    boolean isScaled() { return scaled; }
+
+    // True if the most recently decoded frame would not change the display
+    // Its image data is not decoded and it needn't be drawn or shown
+    boolean getFrameRepeated() { return frameRepeated; }
+
+    // Attributes of the most recently decoded frame
+    int getFrameX() { return tbiImageX; }
+    int getFrameY() { return tbiImageY; }
+    int getFrameWidth() { return tbiWidth; }
+    int getFrameHeight() { return tbiHeight; }
+    int getFrameDelay() { return frameDelay; }
+    int getTransparentColorIndex() { return transparentColorIndex; }
+    int getDisposeMethod() { return disposeMethod; }
+    int getDisposeX() { return disposeX; }
+    int getDisposeY() { return disposeY; }
+    int getDisposeWidth() { return disposeWidth; }
+    int getDisposeHeight() { return disposeHeight; }
+    boolean getNewPalette() { return newPalette; }
+    int getColorCount() { return colorCount; }
+    RGB *getPalette() { return gifPalette; }
+    byte *getImageData() { return imageData; }
+};
+
+#endif
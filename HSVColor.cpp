@@ -0,0 +1,100 @@
+/*
+ * Fixed point HSV color conversion
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Converts colors using integer arithmetic only so effects can afford an
+ * HSV conversion for every pixel of every frame
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "HSVColor.h"
+
+#define MAX_COLOR_VALUE     255
+
+// Components of a color within a sector of the color wheel
+#define HSV_V   0   // value
+#define HSV_P   1   // value at no saturation
+#define HSV_Q   2   // falling from value to p across the sector
+#define HSV_T   3   // rising from p to value across the sector
+
+// Red, green and blue components of each sector of the color wheel
+static const uint8_t hsvSectorComponents[6][3] = {
+    { HSV_V, HSV_T, HSV_P },    // red to yellow
+    { HSV_Q, HSV_V, HSV_P },    // yellow to green
+    { HSV_P, HSV_V, HSV_T },    // green to cyan
+    { HSV_P, HSV_Q, HSV_V },    // cyan to blue
+    { HSV_T, HSV_P, HSV_V },    // blue to magenta
+    { HSV_V, HSV_P, HSV_Q },    // magenta to red
+};
+
+// Scale of the products of saturation and fraction of a sector
+#define HSV_SCALE   (255UL * HSV_SECTOR_STEPS)
+
+// Divide a value times a scaled product by HSV_SCALE, rounding down
+// Exact for every product of an 8 bit value and a number up to HSV_SCALE
+static inline uint8_t hsvScale(uint32_t x) {
+
+    return (x + (x >> 8) + (x >> 16) + 1) >> 16;
+}
+
+// Create a color from a hue (0 - 1535), saturation (0 - 255) and value (0 - 255)
+rgb24 hsvColor(int hue, uint8_t saturation, uint8_t value) {
+
+    uint8_t components[4];
+    rgb24 color;
+
+    // Wrap the hue onto the color wheel
+    if ((unsigned) hue >= HSV_HUE_STEPS) {
+        hue %= HSV_HUE_STEPS;
+        if (hue < 0) {
+            hue += HSV_HUE_STEPS;
+        }
+    }
+    int sector = hue / HSV_SECTOR_STEPS;
+    uint32_t fraction = hue % HSV_SECTOR_STEPS;
+
+    // p = v * (1 - s), q = v * (1 - s * f), t = v * (1 - s * (1 - f))
+    // with s scaled by 255 and f by 256
+    uint32_t scaledSaturation = saturation * (uint32_t) HSV_SECTOR_STEPS;
+    components[HSV_V] = value;
+    components[HSV_P] = hsvScale(value * (HSV_SCALE - scaledSaturation));
+    components[HSV_Q] = hsvScale(value * (HSV_SCALE - (saturation * fraction)));
+    components[HSV_T] = hsvScale(value * (HSV_SCALE - (saturation * (HSV_SECTOR_STEPS - fraction))));
+
+    const uint8_t *sectorComponents = hsvSectorComponents[sector];
+    color.red   = components[sectorComponents[0]];
+    color.green = components[sectorComponents[1]];
+    color.blue  = components[sectorComponents[2]];
+
+    return color;
+}
+
+// Create a color from a hue in degrees (0 - 360.0), saturation (0.0 - 1.0)
+// and value (0.0 - 1.0)
+rgb24 createHSVColor(float hue, float saturation, float value) {
+
+    saturation = constrain(saturation, 0.0f, 1.0f);
+    value = constrain(value, 0.0f, 1.0f);
+
+    // Round to the nearest step
+    return hsvColor((hue * (HSV_HUE_STEPS / 360.0f)) + 0.5f, (saturation * MAX_COLOR_VALUE) + 0.5f, (value * MAX_COLOR_VALUE) + 0.5f);
+}
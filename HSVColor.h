@@ -0,0 +1,48 @@
+/*
+ * Fixed point HSV color conversion
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HSVColor_H
+#define HSVColor_H
+
+#include "SmartMatrix_32x32.h"
+
+// Hues go once around the color wheel from 0 to HSV_HUE_MAX in six sectors
+// of 256 steps: red, yellow, green, cyan, blue, magenta and back to red
+// Hues outside of this range wrap around
+#define HSV_HUE_STEPS       1536
+#define HSV_HUE_MAX         (HSV_HUE_STEPS - 1)
+#define HSV_SECTOR_STEPS    256
+
+// Hue of an angle in degrees
+#define HSV_HUE(degrees)    ((int) ((degrees) * (long) HSV_HUE_STEPS / 360))
+
+// Create a color from a hue (0 - 1535), saturation (0 - 255) and value (0 - 255)
+rgb24 hsvColor(int hue, uint8_t saturation, uint8_t value);
+
+// Create a color from a hue in degrees (0 - 360.0), saturation (0.0 - 1.0)
+// and value (0.0 - 1.0)
+rgb24 createHSVColor(float hue, float saturation, float value);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Palette indexed drawing with color cycling
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "IndexedCanvas.h"
+
+// Fill pixels x0 to x1 of a row
+void IndexedCanvas::fillSpan(int x0, int x1, int y, uint8_t index) {
+
+    if ((y < 0) || (y >= CANVAS_HEIGHT)) {
+        return;
+    }
+    x0 = max(x0, 0);
+    x1 = min(x1, CANVAS_WIDTH - 1);
+
+    if (x1 >= x0) {
+        memset(&indices[y][x0], index, x1 - x0 + 1);
+    }
+}
+
+// Fill the rectangle with corners (x0, y0) and (x1, y1)
+void IndexedCanvas::fillRect(int x0, int y0, int x1, int y1, uint8_t index) {
+
+    y0 = max(y0, 0);
+    y1 = min(y1, CANVAS_HEIGHT - 1);
+
+    for (int y = y0; y <= y1; y++) {
+        fillSpan(x0, x1, y, index);
+    }
+}
+
+// Fill the whole display
+void IndexedCanvas::fill(uint8_t index) {
+
+    memset(indices, index, sizeof(indices));
+}
+
+// Draw the outline of a circle the same way as SmartMatrix::drawCircle()
+void IndexedCanvas::drawCircle(int xc, int yc, int radius, uint8_t index) {
+
+    int a = radius;
+    int b = 0;
+    int radiusError = 1 - a;
+
+    if (radius == 0) {
+        setClippedPixel(xc, yc, index);
+        return;
+    }
+
+    while (a >= b) {
+        setClippedPixel(xc + a, yc + b, index);
+        setClippedPixel(xc + b, yc + a, index);
+        setClippedPixel(xc - a, yc + b, index);
+        setClippedPixel(xc - b, yc + a, index);
+        setClippedPixel(xc - a, yc - b, index);
+        setClippedPixel(xc - b, yc - a, index);
+        setClippedPixel(xc + a, yc - b, index);
+        setClippedPixel(xc + b, yc - a, index);
+
+        b++;
+        if (radiusError < 0) {
+            radiusError += (2 * b) + 1;
+        }
+        else    {
+            a--;
+            radiusError += 2 * (b - a + 1);
+        }
+    }
+}
+
+// Replace the whole palette
+void IndexedCanvas::setColors(const rgb24 *newColors) {
+
+    memcpy(colors, newColors, sizeof(colors));
+}
+
+// Reverse the order of palette entries first to last
+void IndexedCanvas::reverseColors(int first, int last) {
+
+    while (first < last) {
+        rgb24 color = colors[first];
+        colors[first++] = colors[last];
+        colors[last--] = color;
+    }
+}
+
+// Rotate the colors of palette entries first to last by steps entries
+void IndexedCanvas::rotateColors(int first, int last, int steps) {
+
+    first = max(first, 0);
+    last = min(last, INDEXED_CANVAS_COLORS - 1);
+
+    int count = last - first + 1;
+    if (count <= 1) {
+        return;
+    }
+    steps %= count;
+    if (steps < 0) {
+        steps += count;
+    }
+    if (steps == 0) {
+        return;
+    }
+
+    // Moving the last steps entries to the front is three reversals
+    reverseColors(first, last);
+    reverseColors(first, first + steps - 1);
+    reverseColors(first + steps, last);
+}
+
+// Look up the colors of rows y0 to y1 into the back buffer of the matrix
+void IndexedCanvas::resolve(SmartMatrix &matrix, int y0, int y1) {
+
+    y0 = max(y0, 0);
+    y1 = min(y1, CANVAS_HEIGHT - 1);
+    if (y0 > y1) {
+        return;
+    }
+
+    // The rows are consecutive in both buffers
+    Canvas canvas(matrix);
+    rgb24 *dst = canvas.row(y0);
+    const uint8_t *src = indices[y0];
+    int count = (y1 - y0 + 1) * CANVAS_WIDTH;
+
+    for (int i = 0; i < count; i++) {
+        dst[i] = colors[src[i]];
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * Palette indexed drawing with color cycling
+ * for IR Remote Controlled Light Appliance Application for the 32x32 RGB LED Matrix.
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef IndexedCanvas_H
+#define IndexedCanvas_H
+
+#include "Canvas.h"
+
+#define INDEXED_CANVAS_COLORS   256
+
+// An indexed canvas holds a palette index for every pixel and a palette of
+// 256 colors. Drawing into it takes a third of the memory of the display and
+// the colors are only looked up when it is shown, so changing or rotating
+// the palette recolors everything drawn with it without drawing again.
+class IndexedCanvas {
+public:
+    // Palette indices of a row, y must be on the display
+    uint8_t *row(int y) {
+        return indices[y];
+    }
+
+    // Set a pixel without checking it is on the display
+    void setPixel(int x, int y, uint8_t index) {
+        indices[y][x] = index;
+    }
+
+    // These are clipped to the display
+    void fillSpan(int x0, int x1, int y, uint8_t index);
+    void fillRect(int x0, int y0, int x1, int y1, uint8_t index);
+    void fill(uint8_t index);
+    void drawCircle(int xc, int yc, int radius, uint8_t index);
+
+    // Palette
+    void setColor(uint8_t index, rgb24 color) {
+        colors[index] = color;
+    }
+    void setColors(const rgb24 *newColors);
+
+    // Rotate the colors of palette entries first to last by steps entries
+    // towards last, or towards first if steps is negative
+    void rotateColors(int first, int last, int steps);
+
+    // Look up the colors of rows y0 to y1 into the back buffer of the matrix
+    void resolve(SmartMatrix &matrix, int y0 = 0, int y1 = CANVAS_HEIGHT - 1);
+
+    // Look up every pixel into the back buffer and show it
+    void swapBuffers(SmartMatrix &matrix) {
+        resolve(matrix);
+        matrix.swapBuffers();
+    }
+
+private:
+    uint8_t indices[CANVAS_HEIGHT][CANVAS_WIDTH];
+    rgb24 colors[INDEXED_CANVAS_COLORS];
+
+    void setClippedPixel(int x, int y, uint8_t index) {
+        if ((x >= 0) && (x < CANVAS_WIDTH) && (y >= 0) && (y < CANVAS_HEIGHT)) {
+            indices[y][x] = index;
+        }
+    }
+    void reverseColors(int first, int last);
+};
+
+#endif
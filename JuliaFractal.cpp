@@ -28,6 +28,8 @@
 #include "Types.h"
 #include "Codes.h"
 #include "Colors.h"
+#include "HSVColor.h"
+#include "Canvas.h"
 
 void JuliaFractal::runPattern(SmartMatrix matrixRef, IRrecv irReceiverRef, boolean(*checkForTermination)()) {
     matrix = &matrixRef;
@@ -173,7 +175,8 @@ unsigned long JuliaFractal::handleInput() {
 }
 
 void JuliaFractal::draw() {
-    matrix->fillScreen(COLOR_BLACK);
+    Canvas canvas(*matrix);
+    canvas.fill(COLOR_BLACK);
 
     //loop through every pixel
     for (int x = 0; x < w; x++) {
@@ -204,7 +207,7 @@ void JuliaFractal::draw() {
                 // color = colors[i];
 
                 //draw the pixel
-                matrix->drawPixel(x, y, color);
+                canvas.setPixel(x, y, color);
             }
         }
     }
@@ -214,7 +217,7 @@ void JuliaFractal::draw() {
 
 void JuliaFractal::generateColors() {
     for (int i = 0; i < maxIterations; i++) {
-        colors[i] = createHSVColor(i % 360, 1.0, i < maxIterations ? 1.0 : 0.0);
+        colors[i] = hsvColor(HSV_HUE(i % 360), 255, i < maxIterations ? 255 : 0);
     }
 }
 
@@ -237,79 +240,3 @@ void JuliaFractal::reset() {
 
     generateColors();
 }
-
-#define NUM_OF_COLOR_VALUES 256
-#define MIN_COLOR_VALUE     0
-#define MAX_COLOR_VALUE     255
-
-// Create a HSV color
-rgb24 JuliaFractal::createHSVColor(float hue, float saturation, float value) {
-
-    float r, g, b;
-    rgb24 color;
-
-    hsvToRGB(hue, saturation, value, &r, &g, &b);
-
-    color.red = r * MAX_COLOR_VALUE;
-    color.green = g * MAX_COLOR_VALUE;
-    color.blue = b * MAX_COLOR_VALUE;
-
-    return color;
-}
-
-// HSV to RGB color conversion
-// Input arguments
-// hue in degrees (0 - 360.0)
-// saturation (0.0 - 1.0)
-// value (0.0 - 1.0)
-// Output arguments
-// red, green blue (0.0 - 1.0)
-void JuliaFractal::hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue) {
-
-    int i;
-    float f, p, q, t;
-
-    if (saturation == 0) {
-        // achromatic (grey)
-        *red = *green = *blue = value;
-        return;
-    }
-    hue /= 60;                  // sector 0 to 5
-    i = floor(hue);
-    f = hue - i;                // factorial part of h
-    p = value * (1 - saturation);
-    q = value * (1 - saturation * f);
-    t = value * (1 - saturation * (1 - f));
-    switch (i) {
-        case 0:
-            *red = value;
-            *green = t;
-            *blue = p;
-            break;
-        case 1:
-            *red = q;
-            *green = value;
-            *blue = p;
-            break;
-        case 2:
-            *red = p;
-            *green = value;
-            *blue = t;
-            break;
-        case 3:
-            *red = p;
-            *green = q;
-            *blue = value;
-            break;
-        case 4:
-            *red = t;
-            *green = p;
-            *blue = value;
-            break;
-        default:
-            *red = value;
-            *green = p;
-            *blue = q;
-            break;
-    }
-}
\ No newline at end of file
@@ -31,8 +31,6 @@ private:
     void draw();
     void generateColors();
     void reset();
-    rgb24 createHSVColor(float hue, float saturation,  float value);
-    void hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue);
 
 public:
     void runPattern(SmartMatrix matrixRef, IRrecv irReceiverRef, boolean(*checkForTermination)());
@@ -29,45 +29,16 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-#include "SmartMatrix.h"
+#include "GifDecoder.h"
 
+#include "SmartMatrix.h"
 extern SmartMatrix matrix;
 
-extern int lsdWidth;
-extern int lsdHeight;
-extern int lsdBackgroundIndex;
-
-// Table based image attributes
-extern int tbiImageX;
-extern int tbiImageY;
-extern int tbiWidth;
-extern int tbiHeight;
-extern boolean tbiInterlaced;
-
-extern int frameDelay;
-extern int transparentColorIndex;
-extern int disposalMethod;
-
 const int WIDTH = 32;
 const int HEIGHT = 32;
 
-// RGB data structure
-typedef struct {
-    byte Red;
-    byte Green;
-    byte Blue;
-}
-RGB;
-
-extern RGB gifPalette [];
-
-// LZW constants
-// NOTE: LZW_MAXBITS set to 10 to save memory
-#define LZW_MAXBITS    10
-#define LZW_SIZTABLE  (1 << LZW_MAXBITS)
-
 // Masks for 0 .. 16 bits
-unsigned int mask[17] = {
+const unsigned int GifDecoder::mask[17] = {
     0x0000, 0x0001, 0x0003, 0x0007,
     0x000F, 0x001F, 0x003F, 0x007F,
     0x00FF, 0x01FF, 0x03FF, 0x07FF,
@@ -75,42 +46,28 @@ unsigned int mask[17] = {
     0xFFFF
 };
 
-// LZW variables
-byte *pbuf;
-int bbits;
-int bbuf;
-int cursize;                // The current code size
-int curmask;
-int codesize;
-int clear_code;
-int end_code;
-int newcodes;               // First available code
-int top_slot;               // Highest code for current size
-int extra_slot;
-int slot;                   // Last read code
-int fc, oc;
-int bs;                     // Current buffer size for GIF
-byte *sp;
-byte stack[LZW_SIZTABLE];
-byte suffix[LZW_SIZTABLE];
-unsigned int prefix[LZW_SIZTABLE];
-
-// Buffer image data is decoded into
-byte imageData[1024];
-
-// Backup image data buffer for saving portions of image disposal method == 3
-byte imageDataBU[1024];
+// String table shared by all decoders
+uint16_t GifDecoder::prefix[LZW_SIZTABLE];
+byte GifDecoder::suffix[LZW_SIZTABLE];
+byte GifDecoder::length[LZW_SIZTABLE];
+
+// Downscaling sums shared by all decoders
+uint32_t GifDecoder::scaleRed[32];
+uint32_t GifDecoder::scaleGreen[32];
+uint32_t GifDecoder::scaleBlue[32];
+uint32_t GifDecoder::scaleOpaque[32];
 
 // Initialize LZW decoder
 //   csize initial code size in bits
-//   buf input data
-void lzw_decode_init(int csize, byte *buf) {
+// The image data sub-blocks are read from the file as the decoder needs them
+void GifDecoder::lzw_decode_init(int csize) {
 
     // Initialize read buffer variables
-    pbuf = buf;
+    pbuf = lzwBlock;
     bbuf = 0;
     bbits = 0;
     bs = 0;
+    lzwDataEnd = false;
 
     // Initialize decoder variables
     codesize = csize;
@@ -120,16 +77,67 @@ void lzw_decode_init(int csize, byte *buf) {
     clear_code = 1 << codesize;
     end_code = clear_code + 1;
     slot = newcodes = clear_code + 2;
-    oc = fc = -1;
-    sp = stack;
+    oc = -1;
+    pendCode = -1;
+
+    // Root codes are single char strings
+    for (int code = 0; code < clear_code; code++) {
+        prefix[code] = 0;
+        suffix[code] = code;
+        length[code] = 1;
+    }
+}
+
+// Read the next image data sub-block into the input window
+// Returns false when the block terminator is reached
+boolean GifDecoder::lzw_fill_window() {
+
+    if (lzwDataEnd) {
+        return false;
+    }
+    int blockSize = readByte();
+    if (blockSize <= 0) {
+        lzwDataEnd = true;
+        return false;
+    }
+    if (readIntoBuffer(lzwBlock, blockSize) != blockSize) {
+        lzwDataEnd = true;
+        return false;
+    }
+    pbuf = lzwBlock;
+    bs = blockSize;
+
+    // Every sub-block goes into the hash of the frame
+    byte len = blockSize;
+    hashBytes(&len, 1);
+    hashBytes(lzwBlock, blockSize);
+    frameBytes += blockSize;
+    if (firstBlock) {
+        firstBlockHash = frameHash;
+        firstBlock = false;
+    }
+    return true;
+}
+
+// Consume any image data sub-blocks the decoder did not need
+// Leaves the file positioned after the block terminator
+void GifDecoder::lzw_decode_finish() {
+
+    while (lzw_fill_window()) {
+        ;
+    }
+    stats.peakTableSize = max(stats.peakTableSize, slot);
 }
 
 //  Get one code of given number of bits from stream
-int lzw_get_code() {
+int GifDecoder::lzw_get_code() {
 
     while (bbits < cursize) {
         if (!bs) {
-            bs = *pbuf++;
+            if (! lzw_fill_window()) {
+                // Out of data so end the frame
+                return end_code;
+            }
         }
         bbuf |= (*pbuf++) << bbits;
         bbits += 8;
@@ -141,64 +149,147 @@ int lzw_get_code() {
     return c & curmask;
 }
 
+// Write count chars of the string for code into buf, leaving out the last
+// skip chars of the string
+void GifDecoder::lzw_copy_string(int code, int skip, int count, byte *buf) {
+
+    // Walk back from the end of the string to the last char wanted
+    while (skip--) {
+        code = prefix[code];
+    }
+    // Fill the output from back to front
+    buf += count;
+    while (count--) {
+        *--buf = suffix[code];
+        code = prefix[code];
+    }
+}
+
+// Find the length of a string of LZW_LONG_STRING chars or more by walking
+// its prefixes back to its root code
+int GifDecoder::lzw_string_length(int code) {
+
+    int n = 1;
+    while (code >= newcodes) {
+        code = prefix[code];
+        n++;
+    }
+    return n;
+}
+
+// Add the string made of the string for code pc plus char c to the table
+//   n the length of the new string
+inline void GifDecoder::lzw_add_string(int pc, byte c, int n) {
+
+    if (slot < LZW_SIZTABLE) {
+        prefix[slot] = pc;
+        suffix[slot] = c;
+        length[slot] = min(n, LZW_LONG_STRING);
+        slot++;
+    }
+    if (slot >= top_slot) {
+        if (cursize < LZW_MAXBITS) {
+            top_slot <<= 1;
+            curmask = mask[++cursize];
+        }
+    }
+}
+
 // Decode given number of bytes
 //   buf 8 bit output buffer
 //   len number of pixels to decode
 //   returns the number of bytes decoded
-int lzw_decode(byte *buf, int len) {
-    int l, c, code;
+int GifDecoder::lzw_decode(byte *buf, int len) {
+    int l, c, code, n;
+    byte fc;
 
     if (end_code < 0) {
         return 0;
     }
     l = len;
 
-    for (;;) {
-        while (sp > stack) {
-            *buf++ = *(--sp);
-            if ((--l) == 0) {
-                goto the_end;
-            }
+    // Finish any string that did not fit in the previous output buffer
+    if (pendCode >= 0) {
+        n = min(pendCount, l);
+        lzw_copy_string(pendCode, pendCount - n, n, buf);
+        buf += n;
+        l -= n;
+        pendCount -= n;
+        if (pendCount == 0) {
+            pendCode = -1;
+        }
+        if (l == 0) {
+            return len;
         }
+    }
+
+    for (;;) {
         c = lzw_get_code();
+        stats.lzwCodes++;
         if (c == end_code) {
             break;
 
         }
         else if (c == clear_code) {
+            stats.peakTableSize = max(stats.peakTableSize, slot);
             cursize = codesize + 1;
             curmask = mask[cursize];
             slot = newcodes;
             top_slot = 1 << cursize;
-            fc = oc = -1;
+            oc = -1;
 
         }
         else	{
 
             code = c;
-            if ((code == slot) && (fc >= 0)) {
-                *sp++ = fc;
-                code = oc;
-            }
-            else if (code >= slot) {
+            // The first code after a clear must already be in the table and
+            // any other code can at most be the one about to be added
+            if ((code > slot) || ((oc < 0) && (code == slot))) {
                 break;
             }
-            while (code >= newcodes) {
-                *sp++ = suffix[code];
-                code = prefix[code];
+
+            // The code about to be added is the previous string plus its
+            // own first char, so it is added before its string is written.
+            // Any other code adds the previous string plus the first char of
+            // this one once its string is written
+            boolean added = (code == slot);
+            if (added) {
+                n = ocLength + 1;
+                lzw_add_string(oc, ocFirst, n);
+            }
+            else    {
+                n = length[code];
+                if (n == LZW_LONG_STRING) {
+                    n = lzw_string_length(code);
+                }
+            }
+
+            // Output the string for this code. Its first char ends up at the
+            // front of the output
+            if (n <= l) {
+                lzw_copy_string(code, 0, n, buf);
+                fc = buf[0];
+                buf += n;
+                l -= n;
+            }
+            else {
+                // Only part of the string fits, save the rest for next call
+                lzw_copy_string(code, n - l, l, buf);
+                fc = buf[0];
+                pendCode = code;
+                pendCount = n - l;
+                l = 0;
             }
-            *sp++ = code;
-            if ((slot < top_slot) && (oc >= 0)) {
-                suffix[slot] = code;
-                prefix[slot++] = oc;
+
+            if ((oc >= 0) && (! added)) {
+                lzw_add_string(oc, fc, ocLength + 1);
             }
-            fc = code;
             oc = c;
-            if (slot >= top_slot) {
-                if (cursize < LZW_MAXBITS) {
-                    top_slot <<= 1;
-                    curmask = mask[++cursize];
-                }
+            ocLength = n;
+            ocFirst = fc;
+
+            if (l == 0) {
+                goto the_end;
             }
         }
     }
@@ -207,75 +298,345 @@ the_end:
     return len - l;
 }
 
-// Decompress LZW data and display animation frame
-void decompressAndDisplayFrame() {
+// First row and row step of the four passes of an interlaced frame
+static const byte passStart[] = { 0, 4, 2, 1 };
+static const byte passStep[]  = { 8, 8, 4, 2 };
 
-    // Each pixel of image is 8 bits and is an index into the palette
+// Build the row map for a frame of the specified height
+// The rows of an interlaced frame are stored in four passes: every 8th row
+// starting at row 0, every 8th row starting at row 4, every 4th row
+// starting at row 2 and every 2nd row starting at row 1
+void GifDecoder::buildRowMap(int height) {
 
-        // How the image is decoded depends upon whether it is interlaced or not
-    // Decode the interlaced LZW data into the image buffer
-    if (tbiInterlaced) {
-        // Decode every 8th line starting at line 0
-        for (int line = tbiImageY + 0; line < tbiHeight + tbiImageY; line += 8) {
-            lzw_decode(imageData + (line * WIDTH) + tbiImageX, tbiWidth);
+    if ((height == rowMapHeight) && (tbiInterlaced == rowMapInterlaced)) {
+        return;
+    }
+    int passes = tbiInterlaced ? 4 : 1;
+    int i = 0;
+
+    for (int pass = 0; pass < passes; pass++) {
+        int start = tbiInterlaced ? passStart[pass] : 0;
+        int step = tbiInterlaced ? passStep[pass] : 1;
+
+        for (int line = start; line < height; line += step) {
+            rowMap[i++] = line;
         }
-        // Decode every 8th line starting at line 4
-        for (int line = tbiImageY + 4; line < tbiHeight + tbiImageY; line += 8) {
-            lzw_decode(imageData + (line * WIDTH) + tbiImageX, tbiWidth);
-        }    // Decode every 4th line starting at line 2
-        // Decode every 4th line starting at line 2
-        for (int line = tbiImageY + 2; line < tbiHeight + tbiImageY; line += 4) {
-            lzw_decode(imageData + (line * WIDTH) + tbiImageX, tbiWidth);
+    }
+    rowMapHeight = height;
+    rowMapInterlaced = tbiInterlaced;
+}
+
+// Decompress LZW data of a frame into the image data buffer
+// Each pixel of image is 8 bits and is an index into the palette
+void GifDecoder::decompressFrame() {
+
+    // A frame reaching past the display is clipped as it is decoded
+    if ((tbiImageX + tbiWidth > WIDTH) || (tbiImageY + tbiHeight > HEIGHT)) {
+        decompressClippedFrame();
+        return;
+    }
+
+    // A non interlaced frame as wide as the display is one run of pixels
+    if ((! tbiInterlaced) && (tbiImageX == 0) && (tbiWidth == WIDTH)) {
+        lzw_decode(imageData + (tbiImageY * WIDTH), tbiHeight * WIDTH);
+        return;
+    }
+
+    // Otherwise every row is decoded straight to its place in the frame
+    buildRowMap(tbiHeight);
+
+    byte *frame = imageData + (tbiImageY * WIDTH) + tbiImageX;
+    for (int i = 0; i < tbiHeight; i++) {
+        lzw_decode(frame + (rowMap[i] * WIDTH), tbiWidth);
+    }
+}
+
+// Decompress LZW data of a frame that reaches past the display
+// Pixels that fall on the display go to their place in the image data
+// buffer and the rest are decoded into the temp buffer and dropped.
+// Decoding stops when the image data runs out
+void GifDecoder::decompressClippedFrame() {
+
+    int passes = tbiInterlaced ? 4 : 1;
+    for (int pass = 0; pass < passes; pass++) {
+        int start = tbiInterlaced ? passStart[pass] : 0;
+        int step = tbiInterlaced ? passStep[pass] : 1;
+
+        for (int line = start; line < tbiHeight; line += step) {
+            int y = tbiImageY + line;
+            int x = 0;
+
+            while (x < tbiWidth) {
+                int count;
+                byte *dst;
+                if ((y < HEIGHT) && (tbiImageX + x < WIDTH)) {
+                    count = min(tbiWidth - x, WIDTH - (tbiImageX + x));
+                    dst = imageData + (y * WIDTH) + tbiImageX + x;
+                }
+                else    {
+                    count = min(tbiWidth - x, (int) sizeof(tempBuffer));
+                    dst = (byte *) tempBuffer;
+                }
+                if (lzw_decode(dst, count) != count) {
+                    return;
+                }
+                x += count;
+            }
         }
-        // Decode every 2nd line starting at line 1
-        for (int line = tbiImageY + 1; line < tbiHeight + tbiImageY; line += 2) {
-            lzw_decode(imageData + (line * WIDTH) + tbiImageX, tbiWidth);
+    }
+}
+
+// Bring the color lookup table up to date with the palette and the
+// transparent color index of the frame
+void GifDecoder::updateColorLUT() {
+
+    if (! colorLUTValid) {
+        for (int i = 0; i < 256; i++) {
+            colorLUT[i] = ((uint32_t) gifPalette[i].Red << 16) |
+                          ((uint32_t) gifPalette[i].Green << 8) |
+                          gifPalette[i].Blue;
         }
+        colorLUTValid = true;
+        colorLUTTransparentIndex = NO_TRANSPARENT_INDEX;
     }
-    else	{
-        // Decode the non interlaced LZW data into the image data buffer
-        for (int line = tbiImageY; line < tbiHeight + tbiImageY; line++) {
-            lzw_decode(imageData + (line * WIDTH) + tbiImageX, tbiWidth);
+    if (transparentColorIndex != colorLUTTransparentIndex) {
+        // Restore the color of the previous transparent index
+        if (colorLUTTransparentIndex != NO_TRANSPARENT_INDEX) {
+            int i = colorLUTTransparentIndex;
+            colorLUT[i] = ((uint32_t) gifPalette[i].Red << 16) |
+                          ((uint32_t) gifPalette[i].Green << 8) |
+                          gifPalette[i].Blue;
         }
+        if (transparentColorIndex != NO_TRANSPARENT_INDEX) {
+            colorLUT[transparentColorIndex] = LUT_TRANSPARENT;
+        }
+        colorLUTTransparentIndex = transparentColorIndex;
     }
+}
 
-    // Image data is decompressed, now display portion of image affected by frame
-
-    rgb24 color;
-    int yOffset, pixel;
-    for (int y = tbiImageY; y < tbiHeight + tbiImageY; y++) {
-        yOffset = y * WIDTH;
-        for (int x = tbiImageX; x < tbiWidth + tbiImageX; x++) {
-            // Get the next pixel
-            pixel = imageData[yOffset + x];
+// Draw the decoded frame into the back buffer
+// The frame is made visible by presentFrame() when it is due
+void GifDecoder::drawFrame() {
 
-            // Check pixel transparency
-            if (pixel == transparentColorIndex) {
-                continue;
+    // Scaled frames were drawn as they were decoded and repeated frames
+    // are already on the display
+    if (scaled || frameRepeated) {
+        return;
+    }
+    disposeScreenRect();
+    saveScreenRect();
+    updateColorLUT();
+
+    // Display portion of image affected by frame clipped to the display
+    int xEnd = min(tbiImageX + tbiWidth, WIDTH);
+    int yEnd = min(tbiImageY + tbiHeight, HEIGHT);
+
+    rgb24 *backBuffer = matrix.backBuffer();
+    uint32_t color;
+
+    for (int y = tbiImageY; y < yEnd; y++) {
+        byte *src = imageData + (y * WIDTH);
+        rgb24 *dst = backBuffer + (y * WIDTH);
+
+        int x = tbiImageX;
+        while (x < xEnd) {
+            // Skip the run of transparent pixels
+            while ((x < xEnd) && (colorLUT[src[x]] == LUT_TRANSPARENT)) {
+                x++;
             }
+            // Write the run of opaque pixels
+            while ((x < xEnd) && ((color = colorLUT[src[x]]) != LUT_TRANSPARENT)) {
+                dst[x].red = color >> 16;
+                dst[x].green = color >> 8;
+                dst[x].blue = color;
+                x++;
+            }
+        }
+    }
+}
 
-            // Pixel not transparent so get color from palette
-            color.red = gifPalette[pixel].Red;
-            color.green = gifPalette[pixel].Green;
-            color.blue = gifPalette[pixel].Blue;
+// Set up scaling for files larger than the display
+// The logical screen is scaled to fit the display keeping its aspect ratio
+// The frames of a logical screen without an area are clipped instead
+void GifDecoder::scaleBegin() {
 
-            // Draw the pixel
-            matrix.drawPixel(x, y, color);
-        }
+    scaled = ((lsdWidth > WIDTH) || (lsdHeight > HEIGHT)) && (lsdWidth > 0) && (lsdHeight > 0);
+    if (! scaled) {
+        return;
+    }
+    if (lsdWidth >= lsdHeight) {
+        scaleWidth = WIDTH;
+        scaleHeight = max((int) (((long) lsdHeight * WIDTH) / lsdWidth), 1);
+    }
+    else    {
+        scaleHeight = HEIGHT;
+        scaleWidth = max((int) (((long) lsdWidth * HEIGHT) / lsdHeight), 1);
     }
-    // Make animation frame visible
-    matrix.swapBuffers();
+    scaleX0 = (WIDTH - scaleWidth) / 2;
+    scaleY0 = (HEIGHT - scaleHeight) / 2;
+
+    scaleRow = -1;
+    memset(scaleRed, 0, sizeof(scaleRed));
+    memset(scaleGreen, 0, sizeof(scaleGreen));
+    memset(scaleBlue, 0, sizeof(scaleBlue));
+    memset(scaleOpaque, 0, sizeof(scaleOpaque));
+
+    Serial.print("Scaling ");
+    Serial.print(lsdWidth);
+    Serial.print("x");
+    Serial.print(lsdHeight);
+    Serial.print(" to ");
+    Serial.print(scaleWidth);
+    Serial.print("x");
+    Serial.println(scaleHeight);
 }
 
+// Number of logical screen pixels that fall in a display pixel
+//   i position of the display pixel in the scaled logical screen
+//   lsdSize logical screen width or height
+//   scaledSize scaled logical screen width or height
+int scaleSpan(int i, int lsdSize, int scaledSize) {
 
+    long start = (((long) i * lsdSize) + scaledSize - 1) / scaledSize;
+    long end = (((long) (i + 1) * lsdSize) + scaledSize - 1) / scaledSize;
+    return (int) (end - start);
+}
 
+// Display column of a logical screen column
+int GifDecoder::scaleX(int x) {
 
+    return scaleX0 + (int) (((long) x * scaleWidth) / lsdWidth);
+}
 
+// Display row of a logical screen row
+int GifDecoder::scaleY(int y) {
 
+    return scaleY0 + (int) (((long) y * scaleHeight) / lsdHeight);
+}
 
+// Add a run of decoded pixels to the sums of the display row
+//   src the palette indices of the pixels
+//   x logical screen column of the first pixel
+//   count number of pixels
+void GifDecoder::scaleAccumulate(byte *src, int x, int count) {
 
+    // Pixels beyond the logical screen are not shown
+    count = min(count, lsdWidth - x);
 
+    int column = scaleX(x);
+    int nextX = x;
+    uint32_t color;
 
+    while (count-- > 0) {
+        // Move to the display column of this pixel when leaving the last one
+        while (x >= nextX) {
+            column = scaleX(x);
+            nextX = (int) ((((long) (column - scaleX0 + 1) * lsdWidth) + scaleWidth - 1) / scaleWidth);
+        }
+        color = colorLUT[*src++];
+        if (color != LUT_TRANSPARENT) {
+            scaleOpaque[column]++;
+            scaleRed[column] += color >> 16;
+            scaleGreen[column] += (color >> 8) & 0xFF;
+            scaleBlue[column] += color & 0xFF;
+        }
+        x++;
+    }
+}
 
+// Write the averages of the display row being summed into the back buffer
+// Transparent pixels and pixels outside the frame keep the color already in
+// the back buffer, weighted by how many of them fall in the display pixel
+void GifDecoder::scaleResolveRow() {
 
+    if (scaleRow < 0) {
+        return;
+    }
+    rgb24 *dst = matrix.backBuffer() + (scaleRow * WIDTH);
 
+    for (int x = scaleX0; x < scaleX0 + scaleWidth; x++) {
+        if (scaleOpaque[x] == 0) {
+            continue;
+        }
+        uint32_t n = scaleSpan(x - scaleX0, lsdWidth, scaleWidth) * scaleRowHeight;
+        uint32_t keep = (n > scaleOpaque[x]) ? n - scaleOpaque[x] : 0;
+        n = scaleOpaque[x] + keep;
+
+        dst[x].red = (scaleRed[x] + (dst[x].red * keep) + (n / 2)) / n;
+        dst[x].green = (scaleGreen[x] + (dst[x].green * keep) + (n / 2)) / n;
+        dst[x].blue = (scaleBlue[x] + (dst[x].blue * keep) + (n / 2)) / n;
+    }
+    memset(scaleRed, 0, sizeof(scaleRed));
+    memset(scaleGreen, 0, sizeof(scaleGreen));
+    memset(scaleBlue, 0, sizeof(scaleBlue));
+    memset(scaleOpaque, 0, sizeof(scaleOpaque));
+
+    scaleRow = -1;
+}
+
+// Decompress LZW data of a frame larger than the display, scaling it down
+// into the back buffer a row at a time
+// The rows of a non interlaced frame are box filtered. The rows of an
+// interlaced frame arrive out of order, so only the first row of the frame
+// falling in each display row is used
+void GifDecoder::decompressScaledFrame() {
+
+    updateColorLUT();
+
+    int passes = tbiInterlaced ? 4 : 1;
+    for (int pass = 0; pass < passes; pass++) {
+        int start = tbiInterlaced ? passStart[pass] : 0;
+        int step = tbiInterlaced ? passStep[pass] : 1;
+
+        for (int line = start; line < tbiHeight; line += step) {
+            int y = tbiImageY + line;
+            int row = scaleY(y);
+            boolean keep = (y < lsdHeight) &&
+                           ((! tbiInterlaced) || (line == 0) || (scaleY(y - 1) != row));
+
+            if (keep && (row != scaleRow)) {
+                scaleResolveRow();
+                scaleRow = row;
+                scaleRowHeight = tbiInterlaced ? 1 : scaleSpan(row - scaleY0, lsdHeight, scaleHeight);
+            }
+            // Decode the row in pieces that fit the image data buffer
+            // Decoding stops when the image data runs out
+            for (int x = 0; x < tbiWidth; x += sizeof(imageData)) {
+                int wanted = min(tbiWidth - x, (int) sizeof(imageData));
+                int count = lzw_decode(imageData, wanted);
+                if (keep) {
+                    scaleAccumulate(imageData, tbiImageX + x, count);
+                }
+                if (count != wanted) {
+                    scaleResolveRow();
+                    return;
+                }
+            }
+            if (tbiInterlaced) {
+                scaleResolveRow();
+            }
+        }
+    }
+    scaleResolveRow();
+}
+
+// Record the area of the display covered by a scaled frame and dispose of
+// the previous frame before this one is drawn into the back buffer
+void GifDecoder::disposeScaledFrame() {
+
+    keyFrame = false;
+
+    int xEnd = min(tbiImageX + tbiWidth, lsdWidth);
+    int yEnd = min(tbiImageY + tbiHeight, lsdHeight);
+
+    if ((tbiImageX < xEnd) && (tbiImageY < yEnd)) {
+        int x = scaleX(tbiImageX);
+        int y = scaleY(tbiImageY);
+        setFrameRect(x, y, scaleX(xEnd - 1) + 1 - x, scaleY(yEnd - 1) + 1 - y);
+    }
+    else    {
+        setFrameRect(0, 0, 0, 0);
+    }
+    disposeScreenRect();
+    saveScreenRect();
+}
@@ -64,7 +64,16 @@
 #define HAS_SD_CARD     1
 #define HAS_STREAMING_HWD 0
 
+// Setting this to 1 benchmarks the decoding of the general animated GIF
+// files at startup and prints the results to the serial port
+#define RUN_GIF_BENCHMARK 0
+
+// Setting this to 1 prints the number of frames and the drawing times of
+// each pattern that paces its frames to the serial port when it ends
+#define REPORT_FRAME_STATS 0
+
 // Include all include files
+#include <new>
 #include "IRremote.h"
 #include "SdFat.h"
 #include "SdFatUtil.h"
@@ -74,6 +83,10 @@
 #include "Types.h"
 #include "Codes.h"
 #include "Colors.h"
+#include "HSVColor.h"
+#include "Canvas.h"
+#include "IndexedCanvas.h"
+#include "GifDecoder.h"
 
 #include "BrowseAnimationsMode.h"
 #include "QueueArray.h"
@@ -93,8 +106,23 @@ extern int enumerateGIFFiles(const char *directoryName, boolean displayFilenames
 extern void getGIFFilenameByIndex(const char *directoryName, int index, char *pnBuffer);
 extern void chooseRandomGIFFilename(const char *directoryName, char *pnBuffer);
 
+// Defined in FrameCacheFunctions.cpp
+extern void frameCacheInit(byte *ram, int size);
+extern void frameCacheClear();
+
 // Defined in GIFParseFunctions.cpp
-extern unsigned long processGIFFile(const char *pathname, unsigned long(*checkForInput)());
+extern unsigned long processGIFFile(const char *pathname, unsigned long(*checkForInput)(), unsigned long playTime);
+
+// Defined in GIFBenchmarkFunctions.cpp
+extern void benchmarkGIFFiles(const char *directoryName);
+
+// Defined in GIFPrefetchFunctions.cpp
+extern void gifPrefetchBegin(const char *pathname);
+extern boolean gifPrefetchReady(const char *pathname);
+
+// Defined in PackPlayerFunctions.cpp
+extern int packOpen(const char *directoryName);
+extern unsigned long processPackAnimation(int index, unsigned long(*checkForInput)(), unsigned long playTime);
 
 // GIF file directories
 #define GENERAL_GIFS   "/gengifs/"
@@ -126,6 +154,31 @@ boolean sensorPresent;
 SdFat sd;    // SD card interface
 #endif
 
+// The frame cache shares its RAM with the games and the largest patterns as
+// no GIF file plays while they run. Each of them is built in the shared RAM
+// when it starts, which drops the cached frames
+union {
+    byte frameCache[FRAME_CACHE_SIZE];
+    byte breakoutGame[sizeof(BreakoutGame)];
+    byte pacManGame[sizeof(PacManGame)];
+    byte tetrisGame[sizeof(TetrisGame)];
+    byte endingGame[sizeof(EndingGame)];
+    byte maze[sizeof(Maze)];
+    byte rainbowSmoke[sizeof(RainbowSmoke)];
+    double alignment;
+} sharedRAM;
+
+static_assert(sizeof(sharedRAM) >= FRAME_CACHE_SIZE, "frame cache doesn't fit in the shared RAM");
+
+// Take the shared RAM for a game or pattern
+// It is cleared so the object starts out zeroed like a global variable
+void *takeSharedRAM() {
+
+    frameCacheClear();
+    memset(&sharedRAM, 0, sizeof(sharedRAM));
+    return &sharedRAM;
+}
+
 const int DEFAULT_BRIGHTNESS = 100;
 
 const int WIDTH = 32;
@@ -437,7 +490,7 @@ void selectPatternMode() {
                 matrix.swapBuffers();
 
                 // Run pattern
-                (*patternFunction)();
+                runPattern(patternName, patternFunction);
                 patternSelected = true;
                 break;
             }
@@ -750,11 +803,11 @@ void streamingMode() {
 #if (HAS_RTC == 1)
 
 char timeDateBuffer[32];
-char *monthNameArray [] = {
+const char *monthNameArray [] = {
     "", "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
 };
 
-char *dayNameArray [] = {
+const char *dayNameArray [] = {
     "", "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
 };
 
@@ -1387,7 +1440,7 @@ void analogClockMode() {
 // Show Time and Date Mode
 void timeDateMode() {
 
-    unsigned long irCode;
+    unsigned long irCode = 0;
 
     Serial.println("Time and Date Mode");
 
@@ -1547,6 +1600,100 @@ unsigned long checkForInput() {
   return readIRCode();
 }
 
+// Pattern frame pacing
+// A pattern draws everything of a frame into the back buffer and then calls
+// showFrame() to make it visible. The frame is shown at a fixed rate set by
+// the pattern with one swap, so the time taken to draw it is not added to
+// the frame time and objects are not shown one at a time
+unsigned long frameInterval;        // Time between frames in us
+unsigned long frameDue;             // Time the next frame is due in us
+unsigned long frameDrawStart;       // Time drawing of the next frame started in us
+
+// Frame statistics of the running pattern
+unsigned long patternStartTime;     // in ms
+unsigned long patternFrames;        // Number of frames shown
+unsigned long patternLateFrames;    // Number of frames shown after they were due
+unsigned long patternDrawTime;      // Total time spent drawing frames in us
+unsigned long patternMaxDrawTime;   // Longest time spent drawing a frame in us
+
+// Set the number of frames per second the running pattern shows
+void setFrameRate(int framesPerSecond) {
+
+    frameInterval = 1000000UL / framesPerSecond;
+
+    // The first frame is due as soon as it is drawn
+    frameDue = micros();
+    frameDrawStart = frameDue;
+}
+
+// Show the frame drawn into the back buffer when it is due
+// Returns true if the pattern should terminate
+boolean showFrame() {
+
+    unsigned long now = micros();
+    unsigned long drawTime = now - frameDrawStart;
+
+    patternDrawTime += drawTime;
+    if (drawTime > patternMaxDrawTime) {
+        patternMaxDrawTime = drawTime;
+    }
+
+    long early = (long) (frameDue - now);
+    if (early > 0) {
+        delay(early / 1000);
+        delayMicroseconds(early % 1000);
+    }
+    else if (early < 0) {
+        patternLateFrames++;
+
+        // Start again from now rather than hurry to catch up
+        if (-early > (long) frameInterval) {
+            frameDue = now;
+        }
+    }
+    matrix.swapBuffers();
+    patternFrames++;
+
+    frameDue += frameInterval;
+    frameDrawStart = micros();
+
+    return checkForTermination();
+}
+
+// Run a display pattern
+void runPattern(const char *name, ptr2Function function) {
+
+    patternStartTime = millis();
+    patternFrames = 0;
+    patternLateFrames = 0;
+    patternDrawTime = 0;
+    patternMaxDrawTime = 0;
+
+    (*function)();
+
+#if (REPORT_FRAME_STATS == 1)
+    // Patterns that swap by themselves have no frame statistics
+    if (patternFrames != 0) {
+        unsigned long time = millis() - patternStartTime;
+
+        Serial.print("FRAMES,");
+        Serial.print(name);
+        Serial.print(",");
+        Serial.print(patternFrames);
+        Serial.print(",");
+        Serial.print(time);
+        Serial.print(",");
+        Serial.print(patternFrames * 1000.0 / max(time, 1UL), 1);
+        Serial.print(",");
+        Serial.print(patternDrawTime / patternFrames);
+        Serial.print(",");
+        Serial.print(patternMaxDrawTime);
+        Serial.print(",");
+        Serial.println(patternLateFrames);
+    }
+#endif
+}
+
 // Randomly select a pattern to run
 // Return all patterns before allowing any repeats
 int selectPattern() {
@@ -1599,7 +1746,7 @@ void selectPatternAndRun() {
     timeOutEnabled = true;
 
     // Start up the selected pattern by index
-    (*namedPatternFunctions[index].function)();
+    runPattern(namedPatternFunctions[index].name, namedPatternFunctions[index].function);
 }
 
 #if (HAS_RTC == 1)
@@ -1761,6 +1908,9 @@ void setup() {
     // Seed the random number generator
     randomSeed(analogRead(A14));
 
+    // Give the frame cache its RAM
+    frameCacheInit(sharedRAM.frameCache, sizeof(sharedRAM.frameCache));
+
 #if (HAS_SD_CARD == 1)
     // Initialize SD card interface
     Serial.print("Initializing SD card...");
@@ -1829,6 +1979,10 @@ void setup() {
 
     // Clear flags array
     memset(flags, 0, sizeof(flags));
+
+#if (HAS_SD_CARD == 1) && (RUN_GIF_BENCHMARK == 1)
+    benchmarkGIFFiles(GENERAL_GIFS);
+#endif
 }
 
 /*******************************************************************/
@@ -1913,78 +2067,6 @@ void loop() {
 #define MIN_COLOR_VALUE     0
 #define MAX_COLOR_VALUE     255
 
-// HSV to RGB color conversion
-// Input arguments
-// hue in degrees (0 - 360.0)
-// saturation (0.0 - 1.0)
-// value (0.0 - 1.0)
-// Output arguments
-// red, green blue (0.0 - 1.0)
-void hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue) {
-
-    int i;
-    float f, p, q, t;
-
-    if (saturation == 0) {
-        // achromatic (grey)
-        *red = *green = *blue = value;
-        return;
-    }
-    hue /= 60;                  // sector 0 to 5
-    i = floor(hue);
-    f = hue - i;                // factorial part of h
-    p = value * (1 - saturation);
-    q = value * (1 - saturation * f);
-    t = value * (1 - saturation * (1 - f));
-    switch (i) {
-    case 0:
-        *red = value;
-        *green = t;
-        *blue = p;
-        break;
-    case 1:
-        *red = q;
-        *green = value;
-        *blue = p;
-        break;
-    case 2:
-        *red = p;
-        *green = value;
-        *blue = t;
-        break;
-    case 3:
-        *red = p;
-        *green = q;
-        *blue = value;
-        break;
-    case 4:
-        *red = t;
-        *green = p;
-        *blue = value;
-        break;
-    default:
-        *red = value;
-        *green = p;
-        *blue = q;
-        break;
-    }
-}
-
-// Create a HSV color
-rgb24 createHSVColor(float hue, float saturation,  float value) {
-
-    float r, g, b;
-    rgb24 color;
-
-    hsvToRGB(hue, saturation, value, &r, &g, &b);
-
-    color.red   = r * MAX_COLOR_VALUE;
-    color.green = g * MAX_COLOR_VALUE;
-    color.blue =  b * MAX_COLOR_VALUE;
-
-    return color;
-}
-
 // Create an HSV color
 rgb24 createHSVColor(int divisions, int index, float saturation, float value) {
 
@@ -2026,6 +2108,46 @@ rgb24 createHSVColorWithDivisions(int divisions, int index) {
 // Create a palette structure for holding color information
 rgb24 palette[PALETTE_SIZE];
 
+#define MAX_CRAWLERS 120
+
+struct CRAWLER {
+    int x;
+    int y;
+    float hue;
+    int speed;
+};
+
+// Patterns drawn with palette colors draw palette indices into this canvas
+// so their colors can be cycled afterwards. Only one pattern runs at a time
+// and each sets up what it draws with, so the canvas shares its RAM with the
+// crawlers of crawlerPattern()
+static union {
+    IndexedCanvas indexedCanvas;
+    struct CRAWLER crawlers[MAX_CRAWLERS];
+};
+
+// Steps of color cycling per second
+#define COLOR_CYCLE_FRAME_RATE  33
+
+// Cycle the colors first to last of the indexed canvas for duration ms
+// Returns true if the pattern should terminate
+boolean cycleIndexedColors(int first, int last, unsigned long duration) {
+
+    unsigned long endTime = millis() + duration;
+
+    setFrameRate(COLOR_CYCLE_FRAME_RATE);
+
+    while (millis() < endTime) {
+        indexedCanvas.rotateColors(first, last, 1);
+        indexedCanvas.resolve(matrix);
+
+        if (showFrame()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Generate a palette based upon parameter
 void generatePaletteNumber(int paletteNumber) {
 
@@ -2164,11 +2286,7 @@ void generatePaletteNumber(int paletteNumber) {
 
             // Choose color components
             for (i = 0; i < PALETTE_SIZE; i++) {
-                float value = min(255, i * 2) / 255.0;
-                hsvToRGB(i / 3, 1.0, value, &r, &g, &b);
-                palette[i].red   = r * MAX_COLOR_VALUE;
-                palette[i].green = g * MAX_COLOR_VALUE;
-                palette[i].blue =  b * MAX_COLOR_VALUE;
+                palette[i] = hsvColor(HSV_HUE(i / 3), MAX_COLOR_VALUE, min(255, i * 2));
             }
         }
         break;
@@ -2181,11 +2299,7 @@ void generatePaletteNumber(int paletteNumber) {
 
             // Choose color components
             for (i = 0; i < PALETTE_SIZE; i++) {
-                float value = min(255, i * 2) / 255.0;
-                hsvToRGB(120 + i / 3, 1.0, value, &r, &g, &b);
-                palette[i].red   = r * MAX_COLOR_VALUE;
-                palette[i].green = g * MAX_COLOR_VALUE;
-                palette[i].blue =  b * MAX_COLOR_VALUE;
+                palette[i] = hsvColor(HSV_HUE(120 + i / 3), MAX_COLOR_VALUE, min(255, i * 2));
             }
         }
         break;
@@ -2198,11 +2312,7 @@ void generatePaletteNumber(int paletteNumber) {
 
             // Choose color components
             for (i = 0; i < PALETTE_SIZE; i++) {
-                float value = min(255, i * 2) / 255.0;
-                hsvToRGB(240 + i / 3, 1.0, value, &r, &g, &b);
-                palette[i].red   = r * MAX_COLOR_VALUE;
-                palette[i].green = g * MAX_COLOR_VALUE;
-                palette[i].blue =  b * MAX_COLOR_VALUE;
+                palette[i] = hsvColor(HSV_HUE(240 + i / 3), MAX_COLOR_VALUE, min(255, i * 2));
             }
         }
         break;
@@ -2270,7 +2380,7 @@ void radiatingLinesPattern() {
     case 2:
         degreeInc = 30;
         break;
-    case 3:
+    default:
         degreeInc = 36;
         break;
     }
@@ -2284,7 +2394,9 @@ void radiatingLinesPattern() {
     boolean inner = false;
 
     // Pick the delay for this time through
+    // Each spoke is a frame
     int delayTime = random(10, 80);
+    setFrameRate(1000 / delayTime);
 
     while (true) {
 
@@ -2314,16 +2426,12 @@ void radiatingLinesPattern() {
 
             // Draw the spoke
             matrix.drawLine(xi, yi, xo, yo, color);
-            matrix.swapBuffers();
 
-            delay(delayTime);
+            if (showFrame()) {
+                return;
+            }
         }
         colorIndex += 2;
-
-        // Check for termination
-        if (checkForTermination()) {
-            return;
-        }
     }
 }
 
@@ -2337,12 +2445,136 @@ void radiatingLinesPattern() {
 #define PLASMA_TYPE_2  2
 #define PLASMA_TYPE_3  3
 
+// The plasmas are drawn with fixed point arithmetic
+// Phases are 16 bit so they wrap around once per turn
+#define PLASMA_QUARTER_TURN 16384
+#define PLASMA_TIC          1043    // Phase advance per frame, 0.1 radians
+#define PLASMA_SINE_ONE     1024    // Sine of a quarter turn
+
+// Sine of the first quarter turn in 256 steps
+const int16_t plasmaQuarterSine[257] = {
+       0,    6,   13,   19,   25,   31,   38,   44,   50,   57,   63,   69,   75,   82,   88,   94,
+     100,  107,  113,  119,  125,  132,  138,  144,  150,  156,  163,  169,  175,  181,  187,  194,
+     200,  206,  212,  218,  224,  230,  237,  243,  249,  255,  261,  267,  273,  279,  285,  291,
+     297,  303,  309,  315,  321,  327,  333,  339,  345,  351,  357,  363,  369,  374,  380,  386,
+     392,  398,  403,  409,  415,  421,  426,  432,  438,  443,  449,  455,  460,  466,  472,  477,
+     483,  488,  494,  499,  505,  510,  516,  521,  526,  532,  537,  543,  548,  553,  558,  564,
+     569,  574,  579,  584,  590,  595,  600,  605,  610,  615,  620,  625,  630,  635,  640,  645,
+     650,  654,  659,  664,  669,  674,  678,  683,  688,  692,  697,  702,  706,  711,  715,  720,
+     724,  729,  733,  737,  742,  746,  750,  755,  759,  763,  767,  771,  775,  779,  784,  788,
+     792,  796,  799,  803,  807,  811,  815,  819,  822,  826,  830,  834,  837,  841,  844,  848,
+     851,  855,  858,  862,  865,  868,  872,  875,  878,  882,  885,  888,  891,  894,  897,  900,
+     903,  906,  909,  912,  915,  917,  920,  923,  926,  928,  931,  934,  936,  939,  941,  944,
+     946,  948,  951,  953,  955,  958,  960,  962,  964,  966,  968,  970,  972,  974,  976,  978,
+     980,  982,  983,  985,  987,  989,  990,  992,  993,  995,  996,  998,  999, 1000, 1002, 1003,
+    1004, 1006, 1007, 1008, 1009, 1010, 1011, 1012, 1013, 1014, 1015, 1016, 1016, 1017, 1018, 1018,
+    1019, 1020, 1020, 1021, 1021, 1022, 1022, 1022, 1023, 1023, 1023, 1024, 1024, 1024, 1024, 1024,
+    1024
+};
+
+// Phase advance per pixel of the terms of the plasma
+uint16_t plasmaColumnStep;
+uint16_t plasmaRowStep;
+uint16_t plasmaDiagonalStep;
+
+// Phase of the distance of each pixel from the center of the display,
+// indexed by the distance of the pixel from the center in y and in x
+uint16_t plasmaRadius[MIDY + 1][MIDX + 1];
+
+// Sines of the column, row and diagonal terms of the current frame
+int16_t plasmaColumn[WIDTH];
+int16_t plasmaRow[HEIGHT];
+int16_t plasmaDiagonal[WIDTH + HEIGHT - 1];
+
+int plasmaCurrentType;
+
+// Sine of a phase, -PLASMA_SINE_ONE .. +PLASMA_SINE_ONE
+int plasmaSine(uint16_t phase) {
+
+    // Round to the nearest of the 1024 steps of a turn
+    int index = ((phase + 32) >> 6) & 1023;
+
+    switch (index >> 8) {
+    case 0:
+        return plasmaQuarterSine[index];
+    case 1:
+        return plasmaQuarterSine[512 - index];
+    case 2:
+        return -plasmaQuarterSine[index - 512];
+    default:
+        return -plasmaQuarterSine[1024 - index];
+    }
+}
+
+// Phase advance per pixel of a term sin(distance / factor)
+// Steps of more than a turn wrap around like the phases
+uint16_t plasmaPhaseStep(float factor, float distance) {
+
+    return (uint32_t) (((distance * 65536.0) / (2 * M_PI * factor)) + 0.5);
+}
+
+// Set up the terms of a plasma of the specified type using float factors
+// that scale its features
+void plasmaBegin(int type, float f1, float f2, float f3) {
+
+    plasmaCurrentType = type;
+    plasmaColumnStep = plasmaPhaseStep(f1, 1.0);
+    plasmaRowStep = plasmaPhaseStep((type == PLASMA_TYPE_1) ? f1 : f2, 1.0);
+    plasmaDiagonalStep = plasmaPhaseStep(f3, 1.0);
+
+    // The distance from the center never changes so its phase is worked out once
+    float radiusFactor = (type == PLASMA_TYPE_0) ? f1 : f3;
+    for (int y = 0; y <= MIDY; y++) {
+        for (int x = 0; x <= MIDX; x++) {
+            plasmaRadius[y][x] = plasmaPhaseStep(radiusFactor, sqrt((x * x) + (y * y)));
+        }
+    }
+}
+
+// Work out the column, row and diagonal terms of a frame
+//   tic the phase of the frame
+void plasmaFrame(uint16_t tic) {
+
+    uint16_t phase = tic;
+    for (int x = 0; x < WIDTH; x++) {
+        plasmaColumn[x] = plasmaSine(phase);
+        phase += plasmaColumnStep;
+    }
+    phase = tic;
+    for (int y = 0; y < HEIGHT; y++) {
+        plasmaRow[y] = plasmaSine(phase);
+        phase += plasmaRowStep;
+    }
+    phase = tic;
+    for (int i = 0; i < WIDTH + HEIGHT - 1; i++) {
+        plasmaDiagonal[i] = plasmaSine(phase);
+        phase += plasmaDiagonalStep;
+    }
+}
+
+// Value of a pixel of the current frame, -PLASMA_SINE_ONE .. +PLASMA_SINE_ONE
+int plasmaValue(int x, int y, uint16_t tic) {
+
+    switch (plasmaCurrentType) {
+    case PLASMA_TYPE_0:
+        return plasmaSine(plasmaRadius[abs(y - MIDY)][abs(x - MIDX)] + tic);
+
+    case PLASMA_TYPE_1:
+        return (plasmaColumn[x] + plasmaRow[y]) / 2;
+
+    case PLASMA_TYPE_2:
+        return (plasmaColumn[x] + plasmaRow[y] + plasmaDiagonal[x + y]) / 3;
+
+    default:
+        return (plasmaColumn[x] + plasmaRow[y] + plasmaSine(plasmaRadius[abs(y - MIDY)][abs(x - MIDX)] + tic)) / 3;
+    }
+}
+
 // Dynamic plasma pattern
 void plasma1Pattern() {
 
-    float value;
-    float hue;
-    rgb24 color;
+    int hue;
+    uint8_t val;
 
     // Generate some float factors to alter plasma
     float f1 = (float) random(1, 64) / (float) random(1, 8);
@@ -2350,51 +2582,29 @@ void plasma1Pattern() {
     float f3 = (float) random(1, 64) / (float) random(1, 8);
 
     // Select a random plasma type
-    int plasmaType = random(NUM_OF_PLASMAS);
-    float tic = 0.0;
+    plasmaBegin(random(NUM_OF_PLASMAS), f1, f2, f3);
+    uint16_t tic = 0;
 
     while (true) {
-        for (int y = 0; y < HEIGHT; y++) {
-            for (int x = 0; x < WIDTH; x++) {
-
-                // Determine plasma type
-                switch (plasmaType) {
-                case PLASMA_TYPE_0:
-                    {
-                        value = sin(sqrt((x - MIDX) * (x - MIDX) + (y - MIDY) * (y - MIDY)) / f1 + tic);
-                    }
-                    break;
+        // Brightness of this frame, at least 0.6 of the maximum
+        int brightness = plasmaSine(tic + PLASMA_QUARTER_TURN);
+        brightness = max(abs(brightness), (PLASMA_SINE_ONE * 6) / 10);
+        val = ((brightness * MAX_COLOR_VALUE) + (PLASMA_SINE_ONE / 2)) / PLASMA_SINE_ONE;
 
-                case PLASMA_TYPE_1:
-                    {
-                        value = (sin(x / f1 + tic) + sin(y / f1 + tic)) / 2.0;
-                    }
-                    break;
+        plasmaFrame(tic);
 
-                case PLASMA_TYPE_2:
-                    {
-                        value = (sin(x / f1 + tic) + sin(y / f2 + tic) + sin((x + y) / f3 + tic)) / 3.0;
-                    }
-                    break;
+        Canvas canvas(matrix);
+        for (int y = 0; y < HEIGHT; y++) {
+            rgb24 *dst = canvas.row(y);
+            for (int x = 0; x < WIDTH; x++) {
 
-                case PLASMA_TYPE_3:
-                    {
-                        value  = sin(x / f1 + tic);
-                        value += sin(y / f2 + tic);
-                        value += sin(sqrt(((x - MIDX) * (x - MIDX)) + ((y - MIDY) * (y - MIDY))) / f3 + tic);
-                        value /= 3.0;
-                    }
-                    break;
-                }
-                // Convert value of -1 .. +1 to 0 .. 359
-                value *= 180.0;
-                value += 180.0;
+                // Convert value of -1 .. +1 to a hue once around the color wheel
+                hue = (((plasmaValue(x, y, tic) + PLASMA_SINE_ONE) * (HSV_HUE_STEPS / 2)) + (PLASMA_SINE_ONE / 2)) / PLASMA_SINE_ONE;
 
-                color = createHSVColor(value, 1.0,  max(abs(cos(tic)), 0.6));
-                matrix.drawPixel(x, y, color);
+                dst[x] = hsvColor(hue, MAX_COLOR_VALUE, val);
             }
         }
-        tic += 0.1;
+        tic += PLASMA_TIC;
         matrix.swapBuffers();
 
         // Check for termination
@@ -2408,56 +2618,31 @@ void drawPlasma2OfType(int plasmaType, int paletteNumber) {
 
     int x, y;
     int colorIndex;
-    float value = 0;
 
     // Generate specified palette
     generatePaletteNumber(paletteNumber);
+    indexedCanvas.setColors(palette);
 
     // Generate some float factors to alter plasma
     float f1 = (float) random(1, 64) / (float) random(1, 8);
     float f2 = (float) random(1, 64) / (float) random(1, 8);
     float f3 = (float) random(1, 64) / (float) random(1, 8);
 
-    for (y = 0; y < HEIGHT; y++) {
-        for (x = 0; x < WIDTH; x++) {
+    plasmaBegin(plasmaType, f1, f2, f3);
+    plasmaFrame(0);
 
-            // Determine plasma type
-            switch (plasmaType) {
-
-            case PLASMA_TYPE_0:
-                {
-                    value = sin(sqrt((x - MIDX) * (x - MIDX) + (y - MIDY) * (y - MIDY)) / f1);
-                }
-                break;
-
-            case PLASMA_TYPE_1:
-                {
-                    value = (sin(x / f1) + sin(y / f1)) / 2.0;
-                }
-                break;
+    for (y = 0; y < HEIGHT; y++) {
+        uint8_t *dst = indexedCanvas.row(y);
 
-            case PLASMA_TYPE_2:
-                {
-                    value = (sin(x / f1) + sin(y / f2) + sin((x + y) / f3)) / 3.0;
-                }
-                break;
+        for (x = 0; x < WIDTH; x++) {
 
-            case PLASMA_TYPE_3:
-                {
-                    value  = sin(x / f1);
-                    value += sin(y / f2);
-                    value += sin(sqrt(((x - MIDX) * (x - MIDX)) + ((y - MIDY) * (y - MIDY))) / f3);
-                    value /= 3.0;
-                }
-                break;
-            }
             // Scale -1 ... +1 values to 0 ... 255
-            value = (value * 128.0) + 128.0;
-            colorIndex = ((int)value) % 256;
-            rgb24 color = palette[colorIndex];
-
-            matrix.drawPixel(x, y, color);
+            colorIndex = (((plasmaValue(x, y, 0) + PLASMA_SINE_ONE) * 128) / PLASMA_SINE_ONE) % 256;
+            dst[x] = colorIndex;
         }
+
+        // Each row is shown as it is drawn
+        indexedCanvas.resolve(matrix, y, y);
         matrix.swapBuffers();
     }
 }
@@ -2480,10 +2665,8 @@ void plasma2Pattern() {
         // Draw the specified plasma with the specified palette
         drawPlasma2OfType(plasmaType, paletteNumber);
 
-        delay(3000);
-
-        // Check for termination
-        if (checkForTermination()) {
+        // Then cycle its colors
+        if (cycleIndexedColors(0, PALETTE_SIZE - 1, 3000)) {
             return;
         }
     }
@@ -2505,6 +2688,8 @@ void sierpinskiTrianglePattern() {
         colors[i] = createHSVColor(NUMBER_OF_COLORS,  i, 1.0, 1.0);
     }
 
+    setFrameRate(60);
+
     while (true) {
         rgb24 color = colors[colorIndex];
         int x, y, i;
@@ -2514,15 +2699,13 @@ void sierpinskiTrianglePattern() {
                     matrix.drawPixel(x, y, color);
                     matrix.drawPixel(31 - x, 31 - y, color);
                 }
-                
-                // Check for termination
-                if (checkForTermination()) {
-                    return;
-                }
             }
         }
         
-        matrix.swapBuffers();
+        // Show the triangles and check for termination
+        if (showFrame()) {
+            return;
+        }
 
         colorIndex++;
         if(colorIndex == NUMBER_OF_COLORS)
@@ -3396,17 +3579,6 @@ void aurora2Pattern() {
     }
 }
 
-#define MAX_CRAWLERS 120
-
-struct CRAWLER {
-    int x;
-    int y;
-    float hue;
-    int speed;
-};
-
-struct CRAWLER crawlers[MAX_CRAWLERS];
-
 // Initialize crawlers array
 void initializeCrawlers() {
 
@@ -3495,9 +3667,6 @@ void processCrawlers() {
 
             // Draw crawler at new location with new color
             matrix.drawPixel(c.x, c.y, color);
-
-            // Update display
-            matrix.swapBuffers();
         }
     }
 }
@@ -3507,6 +3676,9 @@ void crawlerPattern() {
     // Initialize crawlers to none
     initializeCrawlers();
 
+    // All crawlers move once a frame
+    setFrameRate(5);
+
     while (true) {
 
         int numberToSpawn = random(1, 13);
@@ -3516,8 +3688,8 @@ void crawlerPattern() {
         // Process all crawlers
         processCrawlers();
 
-        // Check for termination
-        if (checkForTermination()) {
+        // Show them and check for termination
+        if (showFrame()) {
             return;
         }
     }
@@ -4136,8 +4308,6 @@ void processXCrawlers() {
                 // Draw crawler at new location with new color
                 matrix.drawPixel(x, c.y - 2, color);
             }
-            // Update display
-            matrix.swapBuffers();
         }
     }
 }
@@ -4149,6 +4319,9 @@ void matrixPattern() {
     // Initialize crawlers
     initializeXCrawlers();
 
+    // All crawlers move once a frame
+    setFrameRate(5);
+
     while (true) {
 
         // Attempt to spawn a random number of crawlers
@@ -4161,8 +4334,8 @@ void matrixPattern() {
         // Process all crawlers
         processXCrawlers();
 
-        // Check for termination
-        if (checkForTermination()) {
+        // Show them and check for termination
+        if (showFrame()) {
             return;
         }
     }
@@ -4794,17 +4967,19 @@ void rectRotatingColorsPattern() {
 
     while (true) {
 
+        Canvas canvas(matrix);
         for (int i = 0; i < numberOfPixels; i++) {
 
             // Find the location of the pixel
             p = pixels[i];
-            matrix.drawPixel(p.x, p.y, colors[colorIndex]);
+            canvas.setPixel(p.x, p.y, colors[colorIndex]);
 
             colorIndex++;
             colorIndex %= 136;
         }
         matrix.swapBuffers();
         colorIndex++;
+        colorIndex %= 136;
 
         // Check for termination
         if (checkForTermination()) {
@@ -4815,8 +4990,6 @@ void rectRotatingColorsPattern() {
 
 void verticalPaletteLinesPattern() {
 
-    rgb24 color;
-
     int colorIncrement = PALETTE_SIZE / WIDTH;
 
     while (true) {
@@ -4825,32 +4998,36 @@ void verticalPaletteLinesPattern() {
         int paletteNumber = random(NUM_OF_PALETTES);
         generatePaletteNumber(paletteNumber);
 
+        // Line x is drawn with color x + 1 of the indexed canvas
+        indexedCanvas.setColor(0, COLOR_BLACK);
+        indexedCanvas.fill(0);
+
         // Pick a random place to start within the palette
         int colorIndex = random(PALETTE_SIZE);
         for (int x = 0; x < WIDTH; x++) {
 
-            color = palette[colorIndex];
+            indexedCanvas.setColor(x + 1, palette[colorIndex]);
             colorIndex += colorIncrement;
             colorIndex %= PALETTE_SIZE;
 
-            matrix.drawLine(x, MINY, x, MAXY, color);
-            matrix.swapBuffers();
+            indexedCanvas.fillRect(x, MINY, x, MAXY, x + 1);
+            indexedCanvas.swapBuffers(matrix);
 
             if (checkForTermination()) {
                 return;
             }
             delay(50);
         }
-        delay(3000);
 
-        matrix.fillScreen(COLOR_BLACK);
+        // Move the colors across the lines
+        if (cycleIndexedColors(1, WIDTH, 3000)) {
+            return;
+        }
     }
 }
 
 void horizontalPaletteLinesPattern() {
 
-    rgb24 color;
-
     int colorIncrement = PALETTE_SIZE / HEIGHT;
 
     while (true) {
@@ -4858,43 +5035,52 @@ void horizontalPaletteLinesPattern() {
         int paletteNumber = random(NUM_OF_PALETTES);
         generatePaletteNumber(paletteNumber);
 
+        // Line y is drawn with color y + 1 of the indexed canvas
+        indexedCanvas.setColor(0, COLOR_BLACK);
+        indexedCanvas.fill(0);
+
         // Pick a random place to start within the palette
         int colorIndex = random(PALETTE_SIZE);
         for (int y = 0; y < HEIGHT; y++) {
 
-            color = palette[colorIndex];
+            indexedCanvas.setColor(y + 1, palette[colorIndex]);
             colorIndex += colorIncrement;
             colorIndex %= PALETTE_SIZE;
 
-            matrix.drawLine(MINX, y, MAXX, y, color);
-            matrix.swapBuffers();
+            indexedCanvas.fillSpan(MINX, MAXX, y, y + 1);
+            indexedCanvas.swapBuffers(matrix);
 
             if (checkForTermination()) {
                 return;
             }
             delay(50);
         }
-        delay(3000);
 
-        matrix.fillScreen(COLOR_BLACK);
+        // Move the colors across the lines
+        if (cycleIndexedColors(1, HEIGHT, 3000)) {
+            return;
+        }
     }
 }
 
-// Generate recursive T Square Fractal
-void generateTSquare(int depth, float x, float y, float w, float h, rgb24 color) {
+// Generate one level of the recursive T Square Fractal
+//   level the number of recursions to the squares to draw
+void generateTSquare(int depth, int level, float x, float y, float w, float h, rgb24 color) {
 
-    // Draw a filled rectangle
-    matrix.fillRectangle(x, y, x + w - 1, y + h - 1, color);
-    matrix.swapBuffers();
+    if (level == 0) {
+        // Draw a filled rectangle
+        matrix.fillRectangle(x, y, x + w - 1, y + h - 1, color);
+        return;
+    }
 
     if (depth > 1)  {
         float newWidth  = w / 2.0;
         float newHeight = h / 2.0;
 
-        generateTSquare(depth - 1, x -     (newWidth / 2.0), y -     (newHeight / 2.0), newWidth, newHeight, color);
-        generateTSquare(depth - 1, x + w - (newWidth / 2.0), y -     (newHeight / 2.0), newWidth, newHeight, color);
-        generateTSquare(depth - 1, x -     (newWidth / 2.0), y + h - (newHeight / 2.0), newWidth, newHeight, color);
-        generateTSquare(depth - 1, x + w - (newWidth / 2.0), y + h - (newHeight / 2.0), newWidth, newHeight, color);
+        generateTSquare(depth - 1, level - 1, x -     (newWidth / 2.0), y -     (newHeight / 2.0), newWidth, newHeight, color);
+        generateTSquare(depth - 1, level - 1, x + w - (newWidth / 2.0), y -     (newHeight / 2.0), newWidth, newHeight, color);
+        generateTSquare(depth - 1, level - 1, x -     (newWidth / 2.0), y + h - (newHeight / 2.0), newWidth, newHeight, color);
+        generateTSquare(depth - 1, level - 1, x + w - (newWidth / 2.0), y + h - (newHeight / 2.0), newWidth, newHeight, color);
 
     }
 }
@@ -4918,9 +5104,14 @@ void tSquareFractalPattern() {
             fgColor = color;
             bgColor = COLOR_BLACK;
         }
+
+        // Show the background and then a level of the fractal every frame
+        setFrameRate(2);
+
         matrix.fillScreen(bgColor);
-        matrix.swapBuffers();
-        delay(500);
+        if (showFrame()) {
+            return;
+        }
 
         x = WIDTH  / 4.0;
         y = HEIGHT / 4.0;
@@ -4930,13 +5121,19 @@ void tSquareFractalPattern() {
         int depth = random(2, 6);
 
         // Generate recursive fractal
-        generateTSquare(depth, x, y, w, h, fgColor);
-
-        delay(2000);
+        for (int level = 0; level < depth; level++) {
+            generateTSquare(depth, level, x, y, w, h, fgColor);
+            if (showFrame()) {
+                return;
+            }
+        }
 
-        // Check for termination
-        if (checkForTermination()) {
-            return;
+        // Hold the finished fractal for 2 seconds, a frame at a time so
+        // the remote is still answered
+        for (int frame = 0; frame < 4; frame++) {
+            if (showFrame()) {
+                return;
+            }
         }
     }
 }
@@ -4963,7 +5160,7 @@ void coloredBoxesPattern() {
                 int yPos = bBorder + countVert  * (bHeight + bSpace);
 
                 // Create filled rect
-                matrix.fillRectangle(xPos, yPos, xPos + bWidth - 1, yPos + bHeight - 1, color);
+                Canvas(matrix).fillRect(xPos, yPos, xPos + bWidth - 1, yPos + bHeight - 1, color);
                 matrix.swapBuffers();
                 delay(80);
             }
@@ -5052,24 +5249,30 @@ void concentricCirclesPattern() {
 
 int rcPaletteIncrement;
 int rcPaletteIndex;
+int rcCircleCount;
 
-void generateCircle(int depth, int xc, int yc, int radius) {
+// Generate one level of the recursive circles
+//   level the number of recursions to the circles to draw
+void generateCircle(int depth, int level, int xc, int yc, int radius) {
 
-    rgb24 color = palette[rcPaletteIndex];
-    rcPaletteIndex += rcPaletteIncrement;
-    rcPaletteIndex %= PALETTE_SIZE;
+    // Circles are numbered in the order of the recursion and each has its
+    // own color in the indexed canvas
+    rcCircleCount++;
 
-    // Draw a circle
-    matrix.drawCircle(xc, yc, radius, color);
-    matrix.swapBuffers();
-    delay(80);
+    if (level == 0) {
+        int colorIndex = (rcPaletteIndex + ((rcCircleCount - 1) * rcPaletteIncrement)) % PALETTE_SIZE;
+        indexedCanvas.setColor(rcCircleCount, palette[colorIndex]);
+
+        // Draw a circle
+        indexedCanvas.drawCircle(xc, yc, radius, rcCircleCount);
+    }
 
     if (depth > 0) {
         // Call this function recursively
-        generateCircle(depth - 1, xc + radius, yc, round(radius / 2.0));
-        generateCircle(depth - 1, xc, yc - radius, round(radius / 2.0));
-        generateCircle(depth - 1, xc - radius, yc, round(radius / 2.0));
-        generateCircle(depth - 1, xc, yc + radius, round(radius / 2.0));
+        generateCircle(depth - 1, level - 1, xc + radius, yc, round(radius / 2.0));
+        generateCircle(depth - 1, level - 1, xc, yc - radius, round(radius / 2.0));
+        generateCircle(depth - 1, level - 1, xc - radius, yc, round(radius / 2.0));
+        generateCircle(depth - 1, level - 1, xc, yc + radius, round(radius / 2.0));
     }
 }
 
@@ -5082,9 +5285,16 @@ void recursiveCircles() {
         generatePaletteNumber(paletteNumber);
         rcPaletteIndex = random(PALETTE_SIZE);
 
-        matrix.fillScreen(COLOR_BLACK);
-        matrix.swapBuffers();
-        delay(500);
+        // Show the background and then a level of circles every frame
+        setFrameRate(2);
+
+        // Color 0 of the indexed canvas is the background
+        indexedCanvas.setColor(0, COLOR_BLACK);
+        indexedCanvas.fill(0);
+        indexedCanvas.resolve(matrix);
+        if (showFrame()) {
+            return;
+        }
 
         xc = MIDX;
         yc = MIDY;
@@ -5096,12 +5306,18 @@ void recursiveCircles() {
         rcPaletteIncrement = PALETTE_SIZE / pow(4, depth);
 
         // Generate recursive fractal
-        generateCircle(depth, xc, yc, radius);
+        for (int level = 0; level <= depth; level++) {
+            rcCircleCount = 0;
+            generateCircle(depth, level, xc, yc, radius);
 
-        delay(2000);
+            indexedCanvas.resolve(matrix);
+            if (showFrame()) {
+                return;
+            }
+        }
 
-        // Check for termination
-        if (checkForTermination()) {
+        // Then pass the colors from circle to circle
+        if (cycleIndexedColors(1, rcCircleCount, 2000)) {
             return;
         }
     }
@@ -5117,8 +5333,12 @@ void animationPattern() {
     chooseRandomGIFFilename(GENERAL_GIFS, pathname);
 
     while (true) {
-        // Run single cycle of animation
-        unsigned long result = processGIFFile(pathname, checkForInput);
+        // Play the animation for the rest of the pattern display time
+        unsigned long playTime = GIF_PLAY_FOREVER;
+        if (timeOutEnabled) {
+            playTime = (timeOut > millis()) ? (timeOut - millis()) : GIF_PLAY_ONCE;
+        }
+        unsigned long result = processGIFFile(pathname, checkForInput, playTime);
 
         // Check for termination
         if (result == IRCODE_HOME || checkForTermination()) {
@@ -5132,62 +5352,82 @@ void animationPattern() {
 void runAnimations(const char *directoryName) {
 
     char pathname[50];
+    char nextPathname[50];
     unsigned long timeOut;
 
     // Turn off any text scrolling
     matrix.scrollText("", 1);
     matrix.setScrollMode(off);
 
-    // Enumerate the animated GIF files in specified directory
-    enumerateGIFFiles(directoryName, false);
+    // Play the precompiled animation pack of the directory if there is one
+    int numberOfAnimations = packOpen(directoryName);
+    boolean playPack = (numberOfAnimations != 0);
+
+    if (! playPack) {
+        // Enumerate the animated GIF files in specified directory
+        numberOfAnimations = enumerateGIFFiles(directoryName, false);
+    }
 
     int startIndex, index;
-    startIndex = index = random(numberOfFiles);
+    startIndex = index = random(numberOfAnimations);
 
     // Do forever
     while (true) {
 
-        // Clear screen for new animation
-        matrix.fillScreen(COLOR_BLACK);
-        matrix.swapBuffers();
+        // Select an animation by index
+        int animationIndex = index++;
 
-        delay(1000);
+        index %= numberOfAnimations;
 
-        // Select an animation file by index
-        getGIFFilenameByIndex(directoryName, index++, pathname);
+        if (index == startIndex) {
+            startIndex = index = random(numberOfAnimations);
+        }
 
-        index %= numberOfFiles;
+        // Clear screen for new animation. An animation that was read ahead
+        // is started on the next frame deadline of the one before it
+        matrix.fillScreen(COLOR_BLACK);
 
-        if (index == startIndex) {
-            startIndex = index = random(numberOfFiles);
+        if (! playPack) {
+            getGIFFilenameByIndex(directoryName, animationIndex, pathname);
+            if (! gifPrefetchReady(pathname)) {
+                matrix.swapBuffers();
+            }
+
+            // Read the animation after this one ahead while this one plays
+            getGIFFilenameByIndex(directoryName, index, nextPathname);
+            gifPrefetchBegin(nextPathname);
+        }
+        else    {
+            matrix.swapBuffers();
         }
 
         // Calculate time in the future to terminate animation
         timeOut = millis() + (ANIMATION_DISPLAY_DURATION_SECONDS * 1000);
 
         while (timeOut > millis()) {
-            unsigned long result = processGIFFile(pathname, checkForInput);
+            // Plays the whole number of loops closest to the display duration
+            unsigned long result;
+            if (playPack) {
+                result = processPackAnimation(animationIndex, checkForInput, ANIMATION_DISPLAY_DURATION_SECONDS * 1000);
+            }
+            else    {
+                result = processGIFFile(pathname, checkForInput, ANIMATION_DISPLAY_DURATION_SECONDS * 1000);
+            }
             // handle user input
             if (result == IRCODE_HOME) {
                 return;
             }
             else if (result == IRCODE_LEFT) {
                 index -= 2;
+                if (index < 0) {
+                    index += numberOfAnimations;
+                }
                 break;
             }
-            else if (result == IRCODE_RIGHT) {
+            else    {
                 break;
             }
         }
-
-        // Check for user termination
-        for (int i = 0; i < 50; i++) {
-            // Has user aborted ?
-            if (readIRCode() == IRCODE_HOME) {
-                return;
-            }
-            delay(20);
-        }
     }
 }
 
@@ -5476,9 +5716,10 @@ void selectGameMode() {
   }
 }
 
-BreakoutGame breakoutGame;
 void runBreakoutGame() {
-  breakoutGame.run(matrix, irReceiver);
+  BreakoutGame *breakoutGame = new (takeSharedRAM()) BreakoutGame();
+  breakoutGame->run(matrix, irReceiver);
+  breakoutGame->~BreakoutGame();
 }
 
 SnakeGame snakeGame;
@@ -5486,28 +5727,34 @@ void runSnakeGame() {
   snakeGame.run(matrix, irReceiver);
 }
 
-PacManGame pacManGame;
 void runPacManGame() {
-  pacManGame.run(matrix, irReceiver);
+  PacManGame *pacManGame = new (takeSharedRAM()) PacManGame();
+  pacManGame->run(matrix, irReceiver);
+  pacManGame->~PacManGame();
 }
 
-TetrisGame tetrisGame;
 void runTetrisGame() {
-  tetrisGame.run(matrix, irReceiver);
+  TetrisGame *tetrisGame = new (takeSharedRAM()) TetrisGame();
+  tetrisGame->run(matrix, irReceiver);
+  tetrisGame->~TetrisGame();
 }
 
-EndingGame endingGame;
 void runEndingGame() {
-  endingGame.run(matrix, irReceiver);
+  EndingGame *endingGame = new (takeSharedRAM()) EndingGame();
+  endingGame->run(matrix, irReceiver);
+  endingGame->~EndingGame();
 }
 
-Maze maze;
 void runMazeGame() {
-  maze.runGame(matrix, irReceiver);
+  Maze *maze = new (takeSharedRAM()) Maze();
+  maze->runGame(matrix, irReceiver);
+  maze->~Maze();
 }
 
 void runMazesPattern() {
-  maze.runPattern(matrix, irReceiver, checkForTermination);
+  Maze *maze = new (takeSharedRAM()) Maze();
+  maze->runPattern(matrix, irReceiver, checkForTermination);
+  maze->~Maze();
 }
 
 Mandelbrot mandelbrot;
@@ -5529,6 +5776,7 @@ void runJuliaFractalPattern() {
 }
 
 void runRainbowSmokePattern() {
-  RainbowSmoke RainbowSmoke;
-  RainbowSmoke.runPattern(matrix, irReceiver, checkForTermination);
+  RainbowSmoke *rainbowSmoke = new (takeSharedRAM()) RainbowSmoke();
+  rainbowSmoke->runPattern(matrix, irReceiver, checkForTermination);
+  rainbowSmoke->~RainbowSmoke();
 }
@@ -28,6 +28,8 @@
 #include "Types.h"
 #include "Codes.h"
 #include "Colors.h"
+#include "HSVColor.h"
+#include "Canvas.h"
 
 void Mandelbrot::runPattern(SmartMatrix matrixRef, IRrecv irReceiverRef, boolean(*checkForTermination)()) {
     matrix = &matrixRef;
@@ -190,7 +192,8 @@ void Mandelbrot::draw() {
     Re_factor = (MaxRe - MinRe) / (imageWidth - 1);
     Im_factor = (MaxIm - MinIm) / (imageHeight - 1);
 
-    matrix->fillScreen(COLOR_BLACK);
+    Canvas canvas(*matrix);
+    canvas.fill(COLOR_BLACK);
 
     for (y = 0; y < imageHeight; ++y)
     {
@@ -216,7 +219,7 @@ void Mandelbrot::draw() {
                 Z_re = Z_re2 - Z_im2 + c_re;
             }
             if (!isInside) {
-                matrix->drawPixel(x, y, colors[n]);
+                canvas.setPixel(x, y, colors[n]);
             }
         }
     }
@@ -239,85 +242,9 @@ void Mandelbrot::generateColors() {
     halfMaxIterations = MaxIterations / 2;
 
     for (int i = 0; i < halfMaxIterations; i++) {
-        colors[i] = createHSVColor(240, 1.0, i * (1.0 / halfMaxIterations));
+        colors[i] = hsvColor(HSV_HUE(240), 255, (i * 255) / halfMaxIterations);
     }
     for (int i = halfMaxIterations; i < MaxIterations; i++) {
-        colors[i] = createHSVColor(240, 2.0 - (i * (1.0 / halfMaxIterations)), 1.0);
+        colors[i] = hsvColor(HSV_HUE(240), (((2 * halfMaxIterations) - i) * 255) / halfMaxIterations, 255);
     }
 }
-
-#define NUM_OF_COLOR_VALUES 256
-#define MIN_COLOR_VALUE     0
-#define MAX_COLOR_VALUE     255
-
-// Create a HSV color
-rgb24 Mandelbrot::createHSVColor(float hue, float saturation, float value) {
-
-    float r, g, b;
-    rgb24 color;
-
-    hsvToRGB(hue, saturation, value, &r, &g, &b);
-
-    color.red = r * MAX_COLOR_VALUE;
-    color.green = g * MAX_COLOR_VALUE;
-    color.blue = b * MAX_COLOR_VALUE;
-
-    return color;
-}
-
-// HSV to RGB color conversion
-// Input arguments
-// hue in degrees (0 - 360.0)
-// saturation (0.0 - 1.0)
-// value (0.0 - 1.0)
-// Output arguments
-// red, green blue (0.0 - 1.0)
-void Mandelbrot::hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue) {
-
-    int i;
-    float f, p, q, t;
-
-    if (saturation == 0) {
-        // achromatic (grey)
-        *red = *green = *blue = value;
-        return;
-    }
-    hue /= 60;                  // sector 0 to 5
-    i = floor(hue);
-    f = hue - i;                // factorial part of h
-    p = value * (1 - saturation);
-    q = value * (1 - saturation * f);
-    t = value * (1 - saturation * (1 - f));
-    switch (i) {
-        case 0:
-            *red = value;
-            *green = t;
-            *blue = p;
-            break;
-        case 1:
-            *red = q;
-            *green = value;
-            *blue = p;
-            break;
-        case 2:
-            *red = p;
-            *green = value;
-            *blue = t;
-            break;
-        case 3:
-            *red = p;
-            *green = q;
-            *blue = value;
-            break;
-        case 4:
-            *red = t;
-            *green = p;
-            *blue = value;
-            break;
-        default:
-            *red = value;
-            *green = p;
-            *blue = q;
-            break;
-    }
-}
\ No newline at end of file
@@ -46,8 +46,6 @@ private:
     void draw();
     void reset();
     void generateColors();
-    rgb24 createHSVColor(float hue, float saturation,  float value);
-    void hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue);
 
 public:
     void runPattern(SmartMatrix matrixRef, IRrecv irReceiverRef, boolean(*checkForTermination)());
@@ -37,7 +37,7 @@ private:
                 case Left:
                     return New(x - 1, y);
 
-                case Right:
+                default:
                     return New(x + 1, y);
             }
         }
@@ -53,7 +53,7 @@ private:
                 case Left:
                     return Right;
 
-                case Right:
+                default:
                     return Left;
             }
         }
@@ -566,7 +566,7 @@ void PacManGame::planNextMove(Ghost &ghost, Point target) {
       r++;
       if (r == 4)
       {
-        r == 0;
+        r = 0;
         direction = directions[r];
       }
 
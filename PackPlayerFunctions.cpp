@@ -0,0 +1,344 @@
+/*
+ * Animated GIFs Display Code for 32x32 RGB LED Matrix
+ *
+ * This file contains code to play the precompiled animation packs made
+ * from the animated GIF directories by tools/gif2pak.py. The frames of a
+ * pack are already decoded so no LZW work is done on the appliance
+ *
+ * Written by: Craig A. Lindley
+ *
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Codes.h"
+#include "GifDecoder.h"
+
+#include "SmartMatrix.h"
+extern SmartMatrix matrix;
+
+const int WIDTH  = 32;
+const int HEIGHT = 32;
+
+// Defined in GIFParseFunctions.cpp
+extern void frameSchedulerStart(boolean continueTimeline);
+extern void presentFrame(int delayTime);
+extern void extendFrame(int delayTime);
+extern void frameSchedulerReport();
+
+// Pack file layout, all values little endian
+//   magic "LAPK", version, reserved, animation count (2 bytes)
+//   table of contents, per animation
+//     offset of the animation in the file (4 bytes), upper case name of
+//     the GIF file it was made from cut to 12 chars and zero padded (13 bytes)
+//   animations, each one
+//     frame count (2 bytes), Netscape loop count (2 bytes, 0 = forever)
+//     color count - 1, palette colors
+//     frames, each one
+//       record size (2 bytes), delay (2 bytes), x, y, width, height
+//       pairs of skip count and literal count covering the rectangle, each
+//       literal count followed by that many palette indices
+// The rectangle of a frame bounds the pixels that changed since the frame
+// before it. The first frame is relative to a black screen
+#define PACK_MAGIC       "LAPK"
+#define PACK_VERSION     1
+#define PACK_HEADER_SIZE 8
+#define PACK_NAME_SIZE   13
+#define PACK_TOC_SIZE    (4 + PACK_NAME_SIZE)
+#define PACK_RECORD_HEADER_SIZE 8
+
+// The GIF decoder is idle while a pack plays, so its palette holds the
+// palette of the animation and its image data buffer the frame record
+// being drawn, a buffer at a time
+#define PACK_BUFFER_SIZE 1024   // Size of the image data buffer of GifDecoder
+
+extern GifDecoder gifDecoder;
+
+SdFile packFile;
+int packAnimationCount;
+int packPrevIndex = -1;
+
+// Frame record being drawn
+byte *packBuffer;
+int packBufferIndex;
+int packBufferCount;
+unsigned int packRecordLeft;    // Bytes of the record still in the file
+
+// Read a little endian value of the specified number of bytes from the pack
+unsigned long packReadValue(int numberOfBytes) {
+
+    byte buffer[4];
+    unsigned long value = 0;
+
+    if (packFile.read(buffer, numberOfBytes) != numberOfBytes) {
+        return 0;
+    }
+    while (numberOfBytes--) {
+        value = (value << 8) | buffer[numberOfBytes];
+    }
+    return value;
+}
+
+// Open the animation pack made from the specified directory
+// The pack of "/gengifs/" is "/gengifs.pak"
+// Returns the number of animations in the pack or 0 if there is none
+int packOpen(const char *directoryName) {
+
+    char pathname[50];
+    char magic[4];
+
+    // Strip the trailing slash from the directory name
+    strcpy(pathname, directoryName);
+    int len = strlen(pathname);
+    if ((len > 1) && (pathname[len - 1] == '/')) {
+        pathname[len - 1] = '\0';
+    }
+    strcat(pathname, ".pak");
+
+    packFile.close();
+    packAnimationCount = 0;
+    packPrevIndex = -1;
+
+    if (! packFile.open(pathname)) {
+        return 0;
+    }
+    if ((packFile.read(magic, 4) != 4) || (strncmp(magic, PACK_MAGIC, 4) != 0) ||
+        (packReadValue(1) != PACK_VERSION)) {
+        Serial.println("Bad animation pack");
+        packFile.close();
+        return 0;
+    }
+    packReadValue(1);
+    packAnimationCount = packReadValue(2);
+
+    Serial.print("Animation pack: ");
+    Serial.print(pathname);
+    Serial.print(" with ");
+    Serial.print(packAnimationCount);
+    Serial.println(" animations");
+
+    return packAnimationCount;
+}
+
+// Read the next byte of the frame record being drawn
+// Returns -1 at the end of the record
+int packReadByte() {
+
+    if (packBufferIndex == packBufferCount) {
+        int count = min(packRecordLeft, (unsigned int) PACK_BUFFER_SIZE);
+        if ((count == 0) || (packFile.read(packBuffer, count) != count)) {
+            return -1;
+        }
+        packRecordLeft -= count;
+        packBufferIndex = 0;
+        packBufferCount = count;
+    }
+    return packBuffer[packBufferIndex++];
+}
+
+// Draw the runs of changed pixels of a frame record read from the pack
+//   x0, y0, width, height the rectangle of the frame
+//   palette the palette of the animation
+// Returns false if the record is not valid
+boolean packDrawFrame(int x0, int y0, int width, int height, RGB *palette) {
+
+    if ((x0 + width > WIDTH) || (y0 + height > HEIGHT)) {
+        return false;
+    }
+
+    rgb24 *backBuffer = matrix.backBuffer();
+
+    int pixelCount = width * height;
+    int pos = 0;
+    int x = 0;
+    int y = 0;
+    while (pos < pixelCount) {
+        // Move past the skipped pixels
+        int skip = packReadByte();
+        int count = packReadByte();
+        if (count < 0) {
+            return false;
+        }
+        pos += skip;
+        x += skip;
+        while (x >= width) {
+            x -= width;
+            y++;
+        }
+        pos += count;
+        if (pos > pixelCount) {
+            return false;
+        }
+        while (count--) {
+            int index = packReadByte();
+            if (index < 0) {
+                return false;
+            }
+            rgb24 *dst = backBuffer + ((y0 + y) * WIDTH) + x0 + x;
+            dst->red = palette[index].Red;
+            dst->green = palette[index].Green;
+            dst->blue = palette[index].Blue;
+            if (++x == width) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return true;
+}
+
+// Play all frames of an animation of the open pack once
+//   frameCount number of frames of the animation
+//   palette the palette of the animation
+//   loopTime set to the length of the loop in ms
+// Returns an IR code if the user wants to abort the animation
+unsigned long packPlayLoop(int frameCount, RGB *palette, unsigned long (*checkForInput)(),
+                           unsigned long *loopTime) {
+
+    byte header[PACK_RECORD_HEADER_SIZE];
+
+    // The first frame is relative to a black screen
+    matrix.fillScreen({
+        0,0,0        }
+    );
+
+    *loopTime = 0;
+    boolean firstFrame = true;
+    while (frameCount--) {
+        // Read the record header and draw the runs that follow it
+        if (packFile.read(header, PACK_RECORD_HEADER_SIZE) != PACK_RECORD_HEADER_SIZE) {
+            Serial.println("Bad animation pack");
+            return ERROR_BADGIFFORMAT;
+        }
+        unsigned int size = header[0] | (header[1] << 8);
+        if (size < PACK_RECORD_HEADER_SIZE) {
+            Serial.println("Bad animation pack");
+            return ERROR_BADGIFFORMAT;
+        }
+        packBufferIndex = packBufferCount = 0;
+        packRecordLeft = size - PACK_RECORD_HEADER_SIZE;
+        if (! packDrawFrame(header[4], header[5], header[6], header[7], palette)) {
+            Serial.println("Bad animation pack");
+            return ERROR_BADGIFFORMAT;
+        }
+        // Skip any part of the record the frame did not need
+        if (packRecordLeft != 0) {
+            packFile.seekCur(packRecordLeft);
+        }
+
+        // Show the frame when it is due. A later frame that changes nothing
+        // keeps the one on the display there for longer
+        int delayTime = header[2] | (header[3] << 8);
+        if ((! firstFrame) && ((header[6] == 0) || (header[7] == 0))) {
+            extendFrame(delayTime * 10);
+        }
+        else    {
+            presentFrame(delayTime * 10);
+        }
+        firstFrame = false;
+        *loopTime += delayTime * 10;
+
+        // Check to see if user wants to abort current animation
+        unsigned long input = checkForInput();
+        if ((input == IRCODE_HOME) || (input == IRCODE_RIGHT) || (input == IRCODE_LEFT)) {
+            return input;
+        }
+    }
+    return ERROR_NONE;
+}
+
+// Play the specified animation of the open pack
+//   playTime how long to play the animation in ms, as for processGIFFile().
+//   The animation is played in whole loops, as many as come closest to the
+//   play time, and not more times than its loop count asks for
+// Returns an IR code if the user wants to abort the animation
+unsigned long processPackAnimation(int index, unsigned long (*checkForInput)(), unsigned long playTime) {
+
+    char name[PACK_NAME_SIZE];
+
+    if ((index < 0) || (index >= packAnimationCount)) {
+        return ERROR_FILEOPEN;
+    }
+
+    // Find the animation in the table of contents
+    packFile.seekSet(PACK_HEADER_SIZE + ((unsigned long) index * PACK_TOC_SIZE));
+    unsigned long offset = packReadValue(4);
+    packFile.read(name, PACK_NAME_SIZE);
+    name[PACK_NAME_SIZE - 1] = '\0';
+
+    Serial.print("Pack animation: ");
+    Serial.println(name);
+
+    // Keep to the timeline of the previous call if this is another loop
+    frameSchedulerStart(index == packPrevIndex);
+    packPrevIndex = index;
+
+    packFile.seekSet(offset);
+    int frameCount = packReadValue(2);
+    int loopCount = packReadValue(2);
+
+    // Read the palette into the idle GIF decoder
+    gifDecoder.close();
+    RGB *palette = gifDecoder.getPalette();
+    packBuffer = gifDecoder.getImageData();
+
+    int colors = packReadValue(1) + 1;
+    if (packFile.read(palette, colors * 3) != colors * 3) {
+        Serial.println("Bad animation pack");
+        return ERROR_BADGIFFORMAT;
+    }
+    uint32_t framesPosition = packFile.curPosition();
+
+    unsigned long result;
+    int loopsLeft = (playTime == GIF_PLAY_ONCE) ? 1 : 0;
+    int loopsPlayed = 0;
+    unsigned long startTime = millis();
+
+    while (true) {
+        packFile.seekSet(framesPosition);
+
+        unsigned long loopTime;
+        result = packPlayLoop(frameCount, palette, checkForInput, &loopTime);
+        loopsPlayed++;
+
+        if (result != ERROR_NONE) {
+            break;
+        }
+        // A loop count of n asks for the animation to be repeated n times
+        if ((loopCount > 0) && (loopsPlayed > loopCount)) {
+            break;
+        }
+        // The length of a loop is known once the first one has been played
+        if ((loopsLeft == 0) && (playTime != GIF_PLAY_FOREVER) && (loopTime != 0)) {
+            loopsLeft = max((int) ((playTime + (loopTime / 2)) / loopTime), 1);
+        }
+        if (loopsLeft != 0) {
+            if (loopsPlayed >= loopsLeft) {
+                break;
+            }
+        }
+        else if ((playTime != GIF_PLAY_FOREVER) && ((millis() - startTime) >= playTime)) {
+            break;
+        }
+    }
+    if (result == ERROR_NONE) {
+        frameSchedulerReport();
+    }
+    return result;
+}
@@ -38,11 +38,6 @@ private:
     void createPaletteGBR();
     void shuffleColors();
 
-#define MAX_COLOR_VALUE     255
-    
-    void hsvToRGB(float hue, float saturation, float value, float * red, float * green, float * blue);
-    rgb24 createHSVColor(float hue, float saturation, float value);
-
     int colorDifference(rgb24 c1, rgb24 c2) {
         int r = c1.red - c2.red;
         int g = c1.green - c2.green;
@@ -0,0 +1,401 @@
+#!/usr/bin/env python3
+#
+# Animation pack transcoder for the 32x32 RGB LED Matrix Light Appliance
+#
+# Converts the animated GIF files of the SD card category directories into
+# precompiled animation packs that the appliance plays without any LZW work.
+# A directory such as /gengifs/ becomes the pack file /gengifs.pak
+#
+# Frames are composed exactly as GifDecoder on the appliance composes them,
+# then stored as run length encoded changes from the frame before
+#
+# Usage: gif2pak.py [--check] <SD card root> [directory ...]
+#
+# Written by: Craig A. Lindley
+#
+# Copyright (c) 2014 Craig A. Lindley
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of
+# this software and associated documentation files (the "Software"), to deal in
+# the Software without restriction, including without limitation the rights to
+# use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+# the Software, and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Pack file layout, all values little endian
+#
+#   magic "LAPK", version, reserved, animation count (2 bytes)
+#   table of contents, per animation
+#     offset of the animation in the file (4 bytes), upper case name of
+#     the GIF file it was made from cut to 12 chars and zero padded (13 bytes)
+#   animations, each one
+#     frame count (2 bytes), Netscape loop count (2 bytes, 0 = forever)
+#     color count - 1, palette colors
+#     frames, each one
+#       record size (2 bytes), delay (2 bytes), x, y, width, height
+#       pairs of skip count and literal count covering the rectangle, each
+#       literal count followed by that many palette indices
+#
+# The rectangle of a frame bounds the pixels that changed since the frame
+# before it. The first frame is relative to a black screen
+
+import os
+import struct
+import sys
+
+WIDTH = 32
+HEIGHT = 32
+
+PACK_MAGIC = b'LAPK'
+PACK_VERSION = 1
+PACK_NAME_SIZE = 13
+
+CATEGORIES = ['gengifs', 'xmasgifs', 'halogifs', 'valgifs', '4thgifs']
+
+DISPOSAL_NONE = 0
+DISPOSAL_LEAVE = 1
+DISPOSAL_BACKGROUND = 2
+DISPOSAL_RESTORE = 3
+
+NO_TRANSPARENT_INDEX = -1
+
+
+class PackError(Exception):
+    pass
+
+
+def lzw_decode(data, code_size, count):
+    """Decode up to count pixels of GIF LZW data, as LZWFunctions.cpp does"""
+    clear_code = 1 << code_size
+    end_code = clear_code + 1
+    strings = [bytes([i]) for i in range(clear_code)] + [b'', b'']
+    cursize = code_size + 1
+    bits = 0
+    nbits = 0
+    pos = 0
+    prev = None
+    out = bytearray()
+
+    while len(out) < count:
+        while nbits < cursize:
+            if pos >= len(data):
+                return out
+            bits |= data[pos] << nbits
+            pos += 1
+            nbits += 8
+        code = bits & ((1 << cursize) - 1)
+        bits >>= cursize
+        nbits -= cursize
+
+        if code == end_code:
+            break
+        if code == clear_code:
+            strings = strings[:clear_code + 2]
+            cursize = code_size + 1
+            prev = None
+            continue
+        slot = len(strings)
+        if prev is None:
+            if code >= slot:
+                break
+        else:
+            if code > slot:
+                break
+            if slot < 4096:
+                first = strings[prev if code == slot else code][0]
+                strings.append(strings[prev] + bytes([first]))
+                slot += 1
+            elif code == slot:
+                break
+            if slot >= (1 << cursize) and cursize < 12:
+                cursize += 1
+        prev = code
+        out += strings[code]
+
+    return out[:count]
+
+
+class GifComposer:
+    """Composes the displayed frames of a GIF file the way GifDecoder does"""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+        self.loop_count = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise PackError('unexpected end of file')
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def word(self):
+        return self.byte() | (self.byte() << 8)
+
+    def bytes(self, n):
+        if self.pos + n > len(self.data):
+            raise PackError('unexpected end of file')
+        b = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return b
+
+    def sub_blocks(self):
+        blocks = bytearray()
+        n = self.byte()
+        while n != 0:
+            blocks += self.bytes(n)
+            n = self.byte()
+        return bytes(blocks)
+
+    def palette(self, count):
+        raw = self.bytes(3 * count)
+        return [tuple(raw[i:i + 3]) for i in range(0, len(raw), 3)]
+
+    def frames(self):
+        """Returns a list of (delay, screen) with a screen of 1024 RGB tuples"""
+        if self.bytes(6) not in (b'GIF87a', b'GIF89a'):
+            raise PackError('not a GIF file')
+        self.word()
+        self.word()
+        packed = self.byte()
+        self.byte()
+        self.byte()
+
+        palette = [(0, 0, 0)] * 256
+        if packed & 0x80:
+            colors = self.palette(1 << ((packed & 7) + 1))
+            palette[:len(colors)] = colors
+
+        image = bytearray(WIDTH * HEIGHT)
+        screen = [(0, 0, 0)] * (WIDTH * HEIGHT)
+        screen_bu = None
+        prev_disposal = DISPOSAL_NONE
+        rect = (0, 0, 0, 0)
+        frames = []
+
+        delay = 0
+        transparent = NO_TRANSPARENT_INDEX
+        disposal = DISPOSAL_NONE
+
+        while True:
+            b = self.byte()
+            if b == 0x21:
+                label = self.byte()
+                if label == 0xf9:
+                    self.byte()
+                    gce = self.byte()
+                    delay = self.word()
+                    transparent = self.byte()
+                    if (gce & 1) == 0:
+                        transparent = NO_TRANSPARENT_INDEX
+                    disposal = (gce >> 2) & 7
+                    if disposal > 3:
+                        disposal = DISPOSAL_NONE
+                    self.byte()
+                elif label == 0xff:
+                    header = self.bytes(self.byte())
+                    blocks = self.sub_blocks()
+                    if header == b'NETSCAPE2.0' and len(blocks) >= 3 and blocks[0] == 1:
+                        self.loop_count = blocks[1] | (blocks[2] << 8)
+                elif label in (0x01, 0xfe):
+                    if label == 0x01:
+                        self.bytes(self.byte())
+                    self.sub_blocks()
+                else:
+                    raise PackError('unknown control extension 0x%02x' % label)
+                continue
+
+            if b != 0x2c:
+                if b != 0x3b:
+                    raise PackError('bad terminator')
+                return frames
+
+            x, y, w, h = self.word(), self.word(), self.word(), self.word()
+            packed = self.byte()
+            if x + w > WIDTH or y + h > HEIGHT:
+                raise PackError('frame is larger than %dx%d' % (WIDTH, HEIGHT))
+            if packed & 0x80:
+                colors = self.palette(1 << ((packed & 7) + 1))
+                palette[:len(colors)] = colors
+
+            # Only the area of the previous frame is disposed of
+            screen = list(screen)
+            rx, ry, rw, rh = rect
+            for yy in range(ry, ry + rh):
+                for xx in range(rx, rx + rw):
+                    if prev_disposal == DISPOSAL_BACKGROUND:
+                        screen[yy * WIDTH + xx] = (0, 0, 0)
+                    elif prev_disposal == DISPOSAL_RESTORE:
+                        screen[yy * WIDTH + xx] = screen_bu[yy * WIDTH + xx]
+
+            prev_disposal = disposal
+            rect = (x, y, w, h)
+            if disposal == DISPOSAL_RESTORE:
+                screen_bu = list(screen)
+
+            code_size = self.byte()
+            pixels = lzw_decode(self.sub_blocks(), code_size, w * h)
+
+            if packed & 0x40:
+                lines = (list(range(0, h, 8)) + list(range(4, h, 8)) +
+                         list(range(2, h, 4)) + list(range(1, h, 2)))
+            else:
+                lines = list(range(h))
+            for i, line in enumerate(lines):
+                row = pixels[i * w:(i + 1) * w]
+                offset = (y + line) * WIDTH + x
+                image[offset:offset + len(row)] = row
+
+            for yy in range(y, y + h):
+                for xx in range(x, x + w):
+                    pixel = image[yy * WIDTH + xx]
+                    if pixel != transparent:
+                        screen[yy * WIDTH + xx] = palette[pixel]
+
+            frames.append((max(delay, 6), screen))
+
+            delay = 0
+            transparent = NO_TRANSPARENT_INDEX
+            disposal = DISPOSAL_NONE
+
+
+def encode_frame(prev, screen, color_index):
+    """Encodes the pixels of screen that differ from prev"""
+    changed = [i for i in range(WIDTH * HEIGHT) if screen[i] != prev[i]]
+    if not changed:
+        return bytes([0, 0, 0, 0])
+
+    xs = [i % WIDTH for i in changed]
+    ys = [i // WIDTH for i in changed]
+    x0, y0 = min(xs), min(ys)
+    w, h = max(xs) - x0 + 1, max(ys) - y0 + 1
+
+    out = bytearray([x0, y0, w, h])
+    skip = 0
+    literals = None
+    for y in range(y0, y0 + h):
+        for x in range(x0, x0 + w):
+            i = y * WIDTH + x
+            if screen[i] == prev[i]:
+                literals = None
+                if skip == 255:
+                    out += bytes([skip, 0])
+                    skip = 0
+                skip += 1
+                continue
+            if literals is None or out[literals] == 255:
+                out.append(skip)
+                literals = len(out)
+                out.append(0)
+                skip = 0
+            out.append(color_index[screen[i]])
+            out[literals] += 1
+    if skip != 0:
+        out += bytes([skip, 0])
+    return bytes(out)
+
+
+def decode_frame(prev, record, palette):
+    """Applies an encoded frame to prev, as the pack player does"""
+    screen = list(prev)
+    x0, y0, w, h = record[0:4]
+    p = 4
+    pos = 0
+    while pos < w * h:
+        pos += record[p]
+        count = record[p + 1]
+        p += 2
+        for _ in range(count):
+            screen[(y0 + pos // w) * WIDTH + x0 + pos % w] = palette[record[p]]
+            p += 1
+            pos += 1
+    return screen
+
+
+def build_animation(path, check):
+    with open(path, 'rb') as f:
+        composer = GifComposer(f.read())
+    frames = composer.frames()
+    if not frames:
+        raise PackError('no frames')
+
+    colors = sorted(set(c for _, screen in frames for c in screen))
+    if len(colors) > 256:
+        raise PackError('%d colors do not fit one palette' % len(colors))
+    color_index = dict((c, i) for i, c in enumerate(colors))
+
+    out = bytearray(struct.pack('<HHB', len(frames), composer.loop_count, len(colors) - 1))
+    for c in colors:
+        out += bytes(c)
+
+    prev = [(0, 0, 0)] * (WIDTH * HEIGHT)
+    for delay, screen in frames:
+        record = encode_frame(prev, screen, color_index)
+        size = 4 + len(record)
+        out += struct.pack('<HH', size, delay) + record
+
+        if check and decode_frame(prev, record, colors) != screen:
+            raise PackError('frame does not round trip')
+        prev = screen
+
+    return bytes(out), len(frames)
+
+
+def build_pack(root, directory, check):
+    source = os.path.join(root, directory)
+    names = sorted(n for n in os.listdir(source)
+                   if n.upper().endswith('.GIF') and n[0] not in '_~')
+
+    animations = []
+    for name in names:
+        try:
+            data, count = build_animation(os.path.join(source, name), check)
+        except (PackError, IOError) as e:
+            print('  skipping %s: %s' % (name, e))
+            continue
+        print('  %-12s %4d frames %6d bytes' % (name, count, len(data)))
+        animations.append((name.upper()[:PACK_NAME_SIZE - 1], data))
+
+    header = PACK_MAGIC + struct.pack('<BBH', PACK_VERSION, 0, len(animations))
+    offset = len(header) + len(animations) * (4 + PACK_NAME_SIZE)
+
+    toc = bytearray()
+    for name, data in animations:
+        toc += struct.pack('<I', offset) + name.encode('ascii').ljust(PACK_NAME_SIZE, b'\0')
+        offset += len(data)
+
+    pack = os.path.join(root, directory + '.pak')
+    with open(pack, 'wb') as f:
+        f.write(header + toc)
+        for _, data in animations:
+            f.write(data)
+    print('%s: %d animations, %d bytes' % (pack, len(animations), offset))
+
+
+def main(args):
+    check = '--check' in args
+    args = [a for a in args if a != '--check']
+    if not args:
+        print('Usage: gif2pak.py [--check] <SD card root> [directory ...]')
+        return 1
+
+    root = args[0]
+    directories = args[1:] or [d for d in CATEGORIES if os.path.isdir(os.path.join(root, d))]
+    for directory in directories:
+        build_pack(root, directory.strip('/'), check)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
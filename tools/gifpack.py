@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# GIF pack builder for the 32x32 RGB LED Matrix Light Appliance
+#
+# Stores the animated GIF files of the SD card category directories back to
+# back in a single GIF pack per directory, so the appliance reaches every
+# animation with a seek in one open file instead of opening each file through
+# the directory. A directory such as /gengifs/ becomes the pack /gengifs.gpk
+#
+# Unlike the animation packs of gif2pak.py the files are stored unchanged
+# and are decoded as they are played
+#
+# Usage: gifpack.py <SD card root> [directory ...]
+#
+# Written by: Craig A. Lindley
+#
+# Copyright (c) 2014 Craig A. Lindley
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of
+# this software and associated documentation files (the "Software"), to deal in
+# the Software without restriction, including without limitation the rights to
+# use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+# the Software, and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# GIF pack file layout, all values little endian
+#
+#   magic "GPAK", version, reserved, file count (2 bytes)
+#   table of contents sorted by name ignoring case, per file
+#     8.3 name (13 bytes), reserved (3 bytes),
+#     offset of the file in the pack (4 bytes), size of the file (4 bytes)
+#   the GIF files, each one starting on an SD card block boundary
+#
+# Must match GIFPackFunctions.cpp
+
+import os
+import struct
+import sys
+
+GIF_PACK_MAGIC = b'GPAK'
+GIF_PACK_VERSION = 1
+GIF_PACK_NAME_SIZE = 13
+GIF_PACK_EXTENSION = '.gpk'
+
+BLOCK_SIZE = 512
+
+CATEGORIES = ['gengifs', 'xmasgifs', 'halogifs', 'valgifs', '4thgifs']
+
+
+def is_short_name(name):
+    """True if name is an 8.3 name the appliance can open"""
+    base, dot, ext = name.partition('.')
+    return 0 < len(base) <= 8 and len(ext) <= 3 and '.' not in ext and ' ' not in name
+
+
+def build_pack(root, directory):
+    source = os.path.join(root, directory)
+    names = sorted((n for n in os.listdir(source)
+                    if n.upper().endswith('.GIF') and n[0] not in '_~'), key=str.lower)
+
+    files = []
+    for name in names:
+        if not is_short_name(name):
+            print('  skipping %s: not an 8.3 name' % name)
+            continue
+        with open(os.path.join(source, name), 'rb') as f:
+            data = f.read()
+        if data[:6] not in (b'GIF87a', b'GIF89a'):
+            print('  skipping %s: not a GIF file' % name)
+            continue
+        files.append((name.upper(), data))
+
+    header = GIF_PACK_MAGIC + struct.pack('<BBH', GIF_PACK_VERSION, 0, len(files))
+    offset = len(header) + len(files) * (GIF_PACK_NAME_SIZE + 3 + 8)
+
+    toc = bytearray()
+    body = bytearray()
+    for name, data in files:
+        # Start every file on a block boundary so its reads are whole blocks
+        padding = -offset % BLOCK_SIZE
+        body += bytes(padding)
+        offset += padding
+        toc += name.encode('ascii').ljust(GIF_PACK_NAME_SIZE + 3, b'\0') + struct.pack('<II', offset, len(data))
+        body += data
+        offset += len(data)
+        print('  %-12s %6d bytes' % (name, len(data)))
+
+    pack = os.path.join(root, directory + GIF_PACK_EXTENSION)
+    if os.path.exists(pack):
+        os.remove(pack)
+    with open(pack, 'wb') as f:
+        # Allocate the whole pack at once where the file system allows so it
+        # is more likely to be stored in consecutive blocks
+        try:
+            os.posix_fallocate(f.fileno(), 0, offset)
+        except (AttributeError, OSError):
+            pass
+        f.write(header + toc + body)
+    print('%s: %d files, %d bytes' % (pack, len(files), offset))
+
+
+def main(args):
+    if not args:
+        print('Usage: gifpack.py <SD card root> [directory ...]')
+        return 1
+
+    root = args[0]
+    directories = args[1:] or [d for d in CATEGORIES if os.path.isdir(os.path.join(root, d))]
+    for directory in directories:
+        build_pack(root, directory.strip('/'))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
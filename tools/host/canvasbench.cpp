@@ -0,0 +1,381 @@
+/*
+ * Canvas benchmark for the host build
+ * Times the drawing of the patterns that draw through Canvas.cpp, each the
+ * way it draws now and the way it drew before through the drawing functions
+ * of the SmartMatrix library, and checks both draw the same pixels.
+ * Prints the best time per frame of each in microseconds over the runs.
+ * Returns 1 if the pixels differ
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SmartMatrix.h"
+#include "Canvas.h"
+#include "HSVColor.h"
+
+#define WIDTH  MATRIX_WIDTH
+#define HEIGHT MATRIX_HEIGHT
+#define MIDX   (WIDTH / 2)
+#define MIDY   (HEIGHT / 2)
+
+#define MAX_COLOR_VALUE 255
+
+// Frames drawn for each timing
+#define FRAMES 2000
+
+SmartMatrix matrix;
+
+// The drawing functions of the SmartMatrix library the patterns used before
+// the canvas. Each pixel is checked against the display, mapped for the
+// rotation and copied a component at a time. The library has them in its
+// own files so they are never inlined into the patterns
+enum rotationDegrees { rotation0, rotation90, rotation180, rotation270 };
+
+struct {
+    rotationDegrees rotation;
+    int localWidth;
+    int localHeight;
+} screenConfig = { rotation0, WIDTH, HEIGHT };
+
+__attribute__((noinline)) void copyRgb24(rgb24 *dst, rgb24 src) {
+    dst->green = src.green;
+    dst->red = src.red;
+    dst->blue = src.blue;
+}
+
+__attribute__((noinline)) void libraryDrawPixel(int16_t x, int16_t y, rgb24 color) {
+    int hwx, hwy;
+
+    if (x < 0 || y < 0 || x >= screenConfig.localWidth || y >= screenConfig.localHeight)
+        return;
+
+    if (screenConfig.rotation == rotation0) {
+        hwx = x;
+        hwy = y;
+    } else if (screenConfig.rotation == rotation180) {
+        hwx = (MATRIX_WIDTH - 1) - x;
+        hwy = (MATRIX_HEIGHT - 1) - y;
+    } else if (screenConfig.rotation == rotation90) {
+        hwx = (MATRIX_WIDTH - 1) - y;
+        hwy = x;
+    } else {
+        hwx = y;
+        hwy = (MATRIX_HEIGHT - 1) - x;
+    }
+    copyRgb24(matrix.backBuffer() + (hwy * WIDTH) + hwx, color);
+}
+
+__attribute__((noinline)) void libraryDrawFastHLine(int16_t x0, int16_t x1, int16_t y, rgb24 color) {
+    if (x1 < x0) {
+        int16_t t = x0;
+        x0 = x1;
+        x1 = t;
+    }
+    if (x1 < 0 || x0 >= screenConfig.localWidth || y < 0 || y >= screenConfig.localHeight)
+        return;
+    if (x0 < 0)
+        x0 = 0;
+    if (x1 >= screenConfig.localWidth)
+        x1 = screenConfig.localWidth - 1;
+
+    // Only the unrotated case is taken
+    for (int i = x0; i <= x1; i++) {
+        copyRgb24(matrix.backBuffer() + (y * WIDTH) + i, color);
+    }
+}
+
+void libraryFillRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 color) {
+    for (int i = y0; i <= y1; i++) {
+        libraryDrawFastHLine(x0, x1, i, color);
+    }
+}
+
+void libraryFillScreen(rgb24 color) {
+    libraryFillRectangle(0, 0, screenConfig.localWidth, screenConfig.localHeight, color);
+}
+
+// The plasma of plasma1Pattern() in LightAppliance.ino, of the type that
+// takes the most work. The sine table is worked out here rather than copied
+#define PLASMA_TIC      1043
+#define PLASMA_SINE_ONE 1024
+
+int16_t plasmaQuarterSine[257];
+uint16_t plasmaColumnStep = 2900;
+uint16_t plasmaRowStep = 1700;
+uint16_t plasmaRadius[MIDY + 1][MIDX + 1];
+int16_t plasmaColumn[WIDTH];
+int16_t plasmaRow[HEIGHT];
+
+int plasmaSine(uint16_t phase) {
+
+    int index = ((phase + 32) >> 6) & 1023;
+
+    switch (index >> 8) {
+    case 0:
+        return plasmaQuarterSine[index];
+    case 1:
+        return plasmaQuarterSine[512 - index];
+    case 2:
+        return -plasmaQuarterSine[index - 512];
+    default:
+        return -plasmaQuarterSine[1024 - index];
+    }
+}
+
+void plasmaBegin() {
+
+    for (int i = 0; i <= 256; i++) {
+        plasmaQuarterSine[i] = lround(PLASMA_SINE_ONE * sin((i * M_PI) / 512));
+    }
+    for (int y = 0; y <= MIDY; y++) {
+        for (int x = 0; x <= MIDX; x++) {
+            plasmaRadius[y][x] = (uint16_t) (sqrt((x * x) + (y * y)) * 65536.0 / (2 * M_PI * 5.0));
+        }
+    }
+}
+
+void plasmaFrame(uint16_t tic) {
+
+    uint16_t phase = tic;
+    for (int x = 0; x < WIDTH; x++) {
+        plasmaColumn[x] = plasmaSine(phase);
+        phase += plasmaColumnStep;
+    }
+    phase = tic;
+    for (int y = 0; y < HEIGHT; y++) {
+        plasmaRow[y] = plasmaSine(phase);
+        phase += plasmaRowStep;
+    }
+}
+
+int plasmaValue(int x, int y, uint16_t tic) {
+
+    return (plasmaColumn[x] + plasmaRow[y] + plasmaSine(plasmaRadius[abs(y - MIDY)][abs(x - MIDX)] + tic)) / 3;
+}
+
+int plasmaHue(int x, int y, uint16_t tic) {
+
+    return (((plasmaValue(x, y, tic) + PLASMA_SINE_ONE) * (HSV_HUE_STEPS / 2)) + (PLASMA_SINE_ONE / 2)) / PLASMA_SINE_ONE;
+}
+
+void plasmaBefore(int frame) {
+
+    uint16_t tic = frame * PLASMA_TIC;
+    plasmaFrame(tic);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            rgb24 color = hsvColor(plasmaHue(x, y, tic), MAX_COLOR_VALUE, 200);
+            libraryDrawPixel(x, y, color);
+        }
+    }
+}
+
+void plasmaAfter(int frame) {
+
+    uint16_t tic = frame * PLASMA_TIC;
+    plasmaFrame(tic);
+    Canvas canvas(matrix);
+    for (int y = 0; y < HEIGHT; y++) {
+        rgb24 *dst = canvas.row(y);
+        for (int x = 0; x < WIDTH; x++) {
+            dst[x] = hsvColor(plasmaHue(x, y, tic), MAX_COLOR_VALUE, 200);
+        }
+    }
+}
+
+// rectRotatingColorsPattern() in LightAppliance.ino
+// Its table of pixels is stood in for by every pixel of the display in
+// rings from the outside in
+struct PIXEL {
+    byte x;
+    byte y;
+};
+
+PIXEL pixels[WIDTH * HEIGHT];
+int numberOfPixels;
+rgb24 rectColors[136];
+
+void rectBegin() {
+
+    for (int ring = 0; ring < MIDX; ring++) {
+        int lo = ring;
+        int hi = WIDTH - 1 - ring;
+        for (int x = lo; x < hi; x++) {
+            pixels[numberOfPixels++] = { (byte) x, (byte) lo };
+        }
+        for (int y = lo; y < hi; y++) {
+            pixels[numberOfPixels++] = { (byte) hi, (byte) y };
+        }
+        for (int x = hi; x > lo; x--) {
+            pixels[numberOfPixels++] = { (byte) x, (byte) hi };
+        }
+        for (int y = hi; y > lo; y--) {
+            pixels[numberOfPixels++] = { (byte) lo, (byte) y };
+        }
+    }
+    for (int i = 0; i < 136; i++) {
+        rectColors[i] = hsvColor((i * HSV_HUE_STEPS) / 136, MAX_COLOR_VALUE, MAX_COLOR_VALUE);
+    }
+}
+
+void rectBefore(int frame) {
+
+    int colorIndex = frame % 136;
+    for (int i = 0; i < numberOfPixels; i++) {
+        libraryDrawPixel(pixels[i].x, pixels[i].y, rectColors[colorIndex]);
+        colorIndex++;
+        colorIndex %= 136;
+    }
+}
+
+void rectAfter(int frame) {
+
+    int colorIndex = frame % 136;
+    Canvas canvas(matrix);
+    for (int i = 0; i < numberOfPixels; i++) {
+        canvas.setPixel(pixels[i].x, pixels[i].y, rectColors[colorIndex]);
+        colorIndex++;
+        colorIndex %= 136;
+    }
+}
+
+// The 16 boxes of coloredBoxesPattern() in LightAppliance.ino, all drawn
+// as one frame
+void boxesBefore(int frame) {
+
+    int colorIndex = frame;
+    for (int countVert = 0; countVert < 4; countVert++) {
+        for (int countHoriz = 0; countHoriz < 4; countHoriz++) {
+            int xPos = 1 + countHoriz * 8;
+            int yPos = 1 + countVert * 8;
+            libraryFillRectangle(xPos, yPos, xPos + 5, yPos + 5, rectColors[colorIndex++ % 136]);
+        }
+    }
+}
+
+void boxesAfter(int frame) {
+
+    int colorIndex = frame;
+    for (int countVert = 0; countVert < 4; countVert++) {
+        for (int countHoriz = 0; countHoriz < 4; countHoriz++) {
+            int xPos = 1 + countHoriz * 8;
+            int yPos = 1 + countVert * 8;
+            Canvas(matrix).fillRect(xPos, yPos, xPos + 5, yPos + 5, rectColors[colorIndex++ % 136]);
+        }
+    }
+}
+
+// The drawing of JuliaFractal::draw() and Mandelbrot, which clear the
+// display and set the pixels inside the set. The fractal math is left out
+// and every other pixel set
+void fractalBefore(int frame) {
+
+    rgb24 black = { 0, 0, 0 };
+    libraryFillScreen(black);
+    for (int x = 0; x < WIDTH; x++) {
+        for (int y = (x + frame) & 1; y < HEIGHT; y += 2) {
+            libraryDrawPixel(x, y, rectColors[(x + y) % 136]);
+        }
+    }
+}
+
+void fractalAfter(int frame) {
+
+    rgb24 black = { 0, 0, 0 };
+    Canvas canvas(matrix);
+    canvas.fill(black);
+    for (int x = 0; x < WIDTH; x++) {
+        for (int y = (x + frame) & 1; y < HEIGHT; y += 2) {
+            canvas.setPixel(x, y, rectColors[(x + y) % 136]);
+        }
+    }
+}
+
+struct Pattern {
+    const char *name;
+    void (*before)(int frame);
+    void (*after)(int frame);
+};
+
+Pattern patterns[] = {
+    { "plasma1",            plasmaBefore,  plasmaAfter },
+    { "rectRotatingColors", rectBefore,    rectAfter },
+    { "coloredBoxes",       boxesBefore,   boxesAfter },
+    { "fractal",            fractalBefore, fractalAfter },
+};
+
+// Time drawing FRAMES frames
+// Returns the time per frame in us
+double timeFrames(void (*draw)(int frame)) {
+
+    unsigned long start = micros();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        draw(frame);
+    }
+    return (double) (micros() - start) / FRAMES;
+}
+
+// True if both ways of drawing give the same pixels for a few frames
+boolean sameFrames(Pattern &pattern) {
+
+    static rgb24 before[WIDTH * HEIGHT];
+
+    for (int frame = 0; frame < 8; frame++) {
+        memset(matrix.backBuffer(), 0x55, sizeof(before));
+        pattern.before(frame);
+        memcpy(before, matrix.backBuffer(), sizeof(before));
+
+        memset(matrix.backBuffer(), 0x55, sizeof(before));
+        pattern.after(frame);
+        if (memcmp(before, matrix.backBuffer(), sizeof(before)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+
+    int runs = (argc > 1) ? atoi(argv[1]) : 3;
+    int result = 0;
+
+    plasmaBegin();
+    rectBegin();
+
+    printf("pattern,before us,after us,speedup,pixels\n");
+    for (unsigned i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        Pattern &pattern = patterns[i];
+        boolean same = sameFrames(pattern);
+        if (! same) {
+            result = 1;
+        }
+
+        // Alternate the two so both see the same load on the computer
+        double before = 1e30;
+        double after = 1e30;
+        for (int run = 0; run < runs; run++) {
+            before = min(before, timeFrames(pattern.before));
+            after = min(after, timeFrames(pattern.after));
+        }
+        printf("%s,%.2f,%.2f,%.2f,%s\n", pattern.name, before, after, before / after, same ? "same" : "DIFFERENT");
+    }
+    return result;
+}
@@ -0,0 +1,159 @@
+/*
+ * Stand-alone driver for the GIF fuzz target, for compilers without libFuzzer
+ * Runs each file named on the command line through LLVMFuzzerTestOneInput()
+ * and then the given number of random mutations of them. Each input is
+ * saved to fuzz-input.gif before it runs, so the input that crashed or hung
+ * is the one left there. An input that takes longer than the timeout is
+ * reported as a hang
+ *
+ * Usage: gif_fuzzer_standalone [-runs=N] [-seed=N] [-timeout=S] file ...
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define INPUT_FILENAME "fuzz-input.gif"
+
+typedef std::vector<uint8_t> Input;
+
+// Values that mean something to a GIF parser
+static const uint8_t interesting[] = {
+    0x00, 0x01, 0x02, 0x0C, 0x7F, 0x80, 0xFF, 0x21, 0x2C, 0x3B, 0xF9, 0xFE
+};
+
+static void onTimeout(int sig) {
+
+    fprintf(stderr, "hang: the input in " INPUT_FILENAME " timed out\n");
+    _exit(2);
+}
+
+static bool readInput(const char *filename, Input &input) {
+
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        input.push_back(c);
+    }
+    fclose(f);
+    return true;
+}
+
+static void runInput(const Input &input, int timeout) {
+
+    FILE *f = fopen(INPUT_FILENAME, "wb");
+    if (f != NULL) {
+        fwrite(input.data(), 1, input.size(), f);
+        fclose(f);
+    }
+    alarm(timeout);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    alarm(0);
+}
+
+// Flip, replace, insert or drop a few bytes, or cut the input short
+static void mutate(Input &input) {
+
+    int mutations = 1 + (rand() % 8);
+    for (int i = 0; (i < mutations) && (! input.empty()); i++) {
+        size_t pos = rand() % input.size();
+        switch (rand() % 6) {
+        case 0:
+            input[pos] ^= 1 << (rand() % 8);
+            break;
+        case 1:
+            input[pos] = rand();
+            break;
+        case 2:
+            input[pos] = interesting[rand() % sizeof(interesting)];
+            break;
+        case 3:
+            input.insert(input.begin() + pos, (uint8_t) rand());
+            break;
+        case 4:
+            input.erase(input.begin() + pos);
+            break;
+        case 5:
+            input.resize(pos);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    long runs = 0;
+    unsigned int seed = 1;
+    int timeout = 10;
+    std::vector<Input> inputs;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = atol(argv[i] + 6);
+        }
+        else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = atoi(argv[i] + 6);
+        }
+        else if (strncmp(argv[i], "-timeout=", 9) == 0) {
+            timeout = atoi(argv[i] + 9);
+        }
+        else    {
+            Input input;
+            if (! readInput(argv[i], input)) {
+                fprintf(stderr, "Could not read %s\n", argv[i]);
+                return 1;
+            }
+            inputs.push_back(input);
+        }
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: gif_fuzzer_standalone [-runs=N] [-seed=N] [-timeout=S] file ...\n");
+        return 1;
+    }
+    signal(SIGALRM, onTimeout);
+    srand(seed);
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        runInput(inputs[i], timeout);
+    }
+    for (long run = 0; run < runs; run++) {
+        Input input = inputs[rand() % inputs.size()];
+        mutate(input);
+        runInput(input, timeout);
+    }
+    fprintf(stderr, "%d files and %ld mutations run\n", (int) inputs.size(), runs);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * libFuzzer target for the GIF decoder of the host build
+ * Each input is written to the SD card as a GIF file, played once and for
+ * a play time by processGIFFile() and then previewed by showGIFPreview(),
+ * which between them run the parser, the LZW decoder, the frame index and
+ * the frame cache. A file that hangs the decoder shows up as a libFuzzer
+ * timeout
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+
+#include "GifDecoder.h"
+#include "SdFat.h"
+#include "SmartMatrix.h"
+
+// Defined in GIFParseFunctions.cpp
+extern GifDecoder gifDecoder;
+extern unsigned long processGIFFile(const char *pathname, unsigned long (*checkForInput)(), unsigned long playTime);
+extern boolean showGIFPreview(const char *pathname);
+
+// Defined in FrameCacheFunctions.cpp
+extern void frameCacheInit(byte *ram, int size);
+extern void frameCacheClear();
+
+// Defined in FrameIndexFunctions.cpp
+extern boolean frameIndexLoad(GifDecoder &decoder, const char *pathname, boolean *opened);
+
+// Defined in LightAppliance.ino on the appliance
+SmartMatrix matrix;
+SdFat sd;
+byte frameCacheRAM[FRAME_CACHE_SIZE];
+
+#define FUZZ_DIRECTORY      "/fuzz"
+#define FUZZ_PATHNAME       "/fuzz/FUZZ.GIF"
+#define FUZZ_INDEX_PATHNAME "/fuzz/_index/FUZZ.GIF"
+#define FUZZ_PLAY_TIME      3000
+
+unsigned long checkForInput() {
+
+    return 0;
+}
+
+// Put the card in a new temporary directory unless FUZZ_SD_ROOT names one
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+
+    static char root[] = "/tmp/gifsdXXXXXX";
+    const char *path = getenv("FUZZ_SD_ROOT");
+    if (path == NULL) {
+        path = mkdtemp(root);
+        if (path == NULL) {
+            perror("mkdtemp");
+            exit(1);
+        }
+    }
+    sdSetRoot(path);
+    if (! sd.begin(0)) {
+        sd.initErrorHalt();
+    }
+    sd.mkdir(FUZZ_DIRECTORY);
+    frameCacheInit(frameCacheRAM, sizeof(frameCacheRAM));
+    Serial.setOutput(NULL);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+
+    SdFile file;
+    if (! file.open(FUZZ_PATHNAME, O_RDWR | O_CREAT | O_TRUNC)) {
+        sd.errorHalt("Could not write " FUZZ_PATHNAME);
+    }
+    file.write(data, size);
+    file.close();
+
+    // Forget what is known about the previous input. The index on the card
+    // could pass for that of this input if both have the same size and time
+    if (file.open(FUZZ_INDEX_PATHNAME)) {
+        file.remove();
+    }
+    frameIndexLoad(gifDecoder, "", NULL);
+    frameCacheClear();
+
+    processGIFFile(FUZZ_PATHNAME, checkForInput, GIF_PLAY_ONCE);
+    processGIFFile(FUZZ_PATHNAME, checkForInput, FUZZ_PLAY_TIME);
+    showGIFPreview(FUZZ_PATHNAME);
+    return 0;
+}
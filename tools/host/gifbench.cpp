@@ -0,0 +1,65 @@
+/*
+ * GIF decoding benchmark for the host build
+ * Runs benchmarkGIFFiles() of GIFBenchmarkFunctions.cpp, the code the
+ * appliance runs when RUN_GIF_BENCHMARK is set, on a host directory standing in
+ * for the SD card and prints the same BENCH lines
+ *
+ * Usage: gifbench <SD card root> [directory [runs]]
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "GifDecoder.h"
+#include "SdFat.h"
+#include "SmartMatrix.h"
+
+// Defined in FrameCacheFunctions.cpp
+extern void frameCacheInit(byte *ram, int size);
+
+// Defined in GIFBenchmarkFunctions.cpp
+extern void benchmarkGIFFiles(const char *directoryName);
+
+// Defined in LightAppliance.ino on the appliance
+SmartMatrix matrix;
+SdFat sd;
+byte frameCacheRAM[FRAME_CACHE_SIZE];
+
+#define DEFAULT_DIRECTORY "/gengifs/"
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: gifbench <SD card root> [directory [runs]]\n");
+        return 1;
+    }
+    sdSetRoot(argv[1]);
+    if (! sd.begin(0)) {
+        sd.initErrorHalt();
+    }
+    frameCacheInit(frameCacheRAM, sizeof(frameCacheRAM));
+    const char *directoryName = (argc > 2) ? argv[2] : DEFAULT_DIRECTORY;
+    int runs = (argc > 3) ? atoi(argv[3]) : 1;
+
+    for (int run = 0; run < runs; run++) {
+        benchmarkGIFFiles(directoryName);
+    }
+    return 0;
+}
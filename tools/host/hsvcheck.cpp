@@ -0,0 +1,108 @@
+/*
+ * HSV color check for the host build
+ * Compares hsvColor() and createHSVColor() of HSVColor.cpp with the float
+ * conversion the sketch used before them, on every hue, saturation and
+ * value hsvColor() takes and on a grid of the float inputs of
+ * createHSVColor(). Every component must be within 1 LSB. Returns 1 if
+ * one is not
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "HSVColor.h"
+
+#define MAX_COLOR_VALUE 255
+
+// The float conversion that was in LightAppliance.ino
+//   hue in degrees (0 - 360.0), saturation and value (0.0 - 1.0)
+rgb24 floatHSVColor(float hue, float saturation, float value) {
+
+    float red, green, blue;
+    rgb24 color;
+
+    if (saturation == 0) {
+        red = green = blue = value;
+    }
+    else    {
+        hue /= 60;
+        int i = floor(hue);
+        float f = hue - i;
+        float p = value * (1 - saturation);
+        float q = value * (1 - saturation * f);
+        float t = value * (1 - saturation * (1 - f));
+        switch (i) {
+        case 0:  red = value; green = t;     blue = p;     break;
+        case 1:  red = q;     green = value; blue = p;     break;
+        case 2:  red = p;     green = value; blue = t;     break;
+        case 3:  red = p;     green = q;     blue = value; break;
+        case 4:  red = t;     green = p;     blue = value; break;
+        default: red = value; green = p;     blue = q;     break;
+        }
+    }
+    color.red   = red * MAX_COLOR_VALUE;
+    color.green = green * MAX_COLOR_VALUE;
+    color.blue  = blue * MAX_COLOR_VALUE;
+    return color;
+}
+
+int maxError;
+long errors;
+
+void compare(rgb24 a, rgb24 b) {
+
+    int error = max(max(abs(a.red - b.red), abs(a.green - b.green)), abs(a.blue - b.blue));
+    maxError = max(maxError, error);
+    if (error > 1) {
+        errors++;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    // Every input of hsvColor()
+    for (int hue = 0; hue < HSV_HUE_STEPS; hue++) {
+        for (int saturation = 0; saturation <= MAX_COLOR_VALUE; saturation++) {
+            for (int value = 0; value <= MAX_COLOR_VALUE; value++) {
+                compare(hsvColor(hue, saturation, value),
+                        floatHSVColor(hue * (360.0f / HSV_HUE_STEPS),
+                                      saturation / (float) MAX_COLOR_VALUE, value / (float) MAX_COLOR_VALUE));
+            }
+        }
+    }
+    printf("hsvColor: largest difference %d, %ld colors more than 1 LSB out\n", maxError, errors);
+    int failed = (errors != 0);
+
+    // Hues in tenths of a degree below 360 with saturation and value in hundredths
+    maxError = 0;
+    errors = 0;
+    for (int hue = 0; hue < 3600; hue++) {
+        for (int saturation = 0; saturation <= 100; saturation++) {
+            for (int value = 0; value <= 100; value++) {
+                compare(createHSVColor(hue / 10.0f, saturation / 100.0f, value / 100.0f),
+                        floatHSVColor(hue / 10.0f, saturation / 100.0f, value / 100.0f));
+            }
+        }
+    }
+    printf("createHSVColor: largest difference %d, %ld colors more than 1 LSB out\n", maxError, errors);
+    failed |= (errors != 0);
+
+    return failed;
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+#
+# Sketch to C++ converter for the host build of the 32x32 RGB LED Matrix
+# Light Appliance
+#
+# Does what the Arduino IDE does to LightAppliance.ino before compiling it:
+# prototypes of the functions the sketch defines are put after its includes,
+# so a function can be called above its definition. A #line directive keeps
+# the compiler messages pointing at the lines of the sketch
+#
+# Usage: ino2cpp.py <sketch> > <C++ file>
+#
+# Written by: Craig A. Lindley
+#
+# Copyright (c) 2014 Craig A. Lindley
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of
+# this software and associated documentation files (the "Software"), to deal in
+# the Software without restriction, including without limitation the rights to
+# use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+# the Software, and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+import re
+import sys
+
+# A function definition that starts at the beginning of a line
+DEFINITION = re.compile(r'^([A-Za-z_][\w\s\*&:<>]*?[\s\*&])([A-Za-z_]\w*)\s*\(([^;{]*)\)\s*\{')
+
+NOT_TYPES = ('else', 'return', 'struct', 'class', 'if', 'while', 'for', 'switch')
+
+
+def convert(lines, name):
+    prototypes = []
+    first = None
+    for number, line in enumerate(lines):
+        match = DEFINITION.match(line)
+        if match and match.group(1).split()[0] not in NOT_TYPES:
+            prototypes.append('%s%s(%s);' % match.groups())
+            if first is None:
+                first = number
+
+    if first is None:
+        return lines
+    includes = [n for n, line in enumerate(lines[:first]) if line.startswith('#include')]
+    insert = includes[-1] + 1 if includes else 0
+    return lines[:insert] + prototypes + ['#line %d "%s"' % (insert + 1, name)] + lines[insert:]
+
+
+def main(args):
+    if len(args) != 1:
+        print('Usage: ino2cpp.py <sketch> > <C++ file>')
+        return 1
+
+    with open(args[0], encoding='latin-1') as f:
+        lines = f.read().split('\n')
+    sys.stdout.write('\n'.join(convert(lines, args[0])))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
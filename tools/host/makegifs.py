@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+#
+# Test GIF maker for the host build of the 32x32 RGB LED Matrix Light Appliance
+#
+# Writes a small set of animated GIF files to <SD card root>/gengifs/ that
+# between them use the features GifDecoder handles: global and local color
+# tables, interlacing, transparency, the three disposal methods, partial
+# frames, repeated frames, loop counts, comments, 8 bit LZW codes that fill
+# the string table and images larger than the matrix. The files are the same
+# on every run so benchmark runs can be compared
+#
+# Usage: makegifs.py <SD card root>
+#
+# Written by: Craig A. Lindley
+#
+# Copyright (c) 2014 Craig A. Lindley
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of
+# this software and associated documentation files (the "Software"), to deal in
+# the Software without restriction, including without limitation the rights to
+# use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+# the Software, and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+import os
+import random
+import struct
+import sys
+
+DIRECTORY = 'gengifs'
+
+MAX_CODE_BITS = 12
+
+
+def lzw_encode(pixels, code_size):
+    """Encode pixels as GIF LZW data, clearing when the string table is full"""
+    clear_code = 1 << code_size
+    end_code = clear_code + 1
+
+    codes = []
+    table = None
+    cursize = 0
+    nextcode = 0
+    string = b''
+    for p in [None] + list(pixels):
+        if table is None:
+            table = dict((bytes([i]), i) for i in range(clear_code))
+            nextcode = end_code + 1
+            cursize = code_size + 1
+            codes.append((clear_code, cursize))
+        if p is None:
+            continue
+        extended = string + bytes([p])
+        if extended in table:
+            string = extended
+            continue
+        codes.append((table[string], cursize))
+        if nextcode < (1 << MAX_CODE_BITS):
+            table[extended] = nextcode
+            nextcode += 1
+            if nextcode > (1 << cursize) and cursize < MAX_CODE_BITS:
+                cursize += 1
+        else:
+            codes.append((clear_code, cursize))
+            table = dict((bytes([i]), i) for i in range(clear_code))
+            nextcode = end_code + 1
+            cursize = code_size + 1
+        string = bytes([p])
+    if string:
+        codes.append((table[string], cursize))
+    codes.append((end_code, cursize))
+
+    out = bytearray()
+    bits = 0
+    nbits = 0
+    for code, size in codes:
+        bits |= code << nbits
+        nbits += size
+        while nbits >= 8:
+            out.append(bits & 0xff)
+            bits >>= 8
+            nbits -= 8
+    if nbits:
+        out.append(bits & 0xff)
+    return bytes(out)
+
+
+def sub_blocks(data):
+    out = bytearray()
+    for i in range(0, len(data), 255):
+        chunk = data[i:i + 255]
+        out.append(len(chunk))
+        out += chunk
+    out.append(0)
+    return bytes(out)
+
+
+def color_table(palette, bits):
+    palette = list(palette) + [(0, 0, 0)] * ((1 << bits) - len(palette))
+    return b''.join(bytes(c) for c in palette[:1 << bits])
+
+
+class GifWriter:
+    """Builds a GIF89a file in memory"""
+
+    def __init__(self, width, height, palette, bits, background=0, loops=None):
+        self.bits = bits
+        self.out = bytearray(b'GIF89a')
+        self.out += struct.pack('<HHBBB', width, height,
+                                0x80 | ((bits - 1) << 4) | (bits - 1), background, 0)
+        self.out += color_table(palette, bits)
+        if loops is not None:
+            self.out += b'\x21\xff\x0bNETSCAPE2.0\x03\x01' + struct.pack('<H', loops) + b'\x00'
+
+    def comment(self, text):
+        self.out += b'\x21\xfe' + sub_blocks(text.encode('ascii'))
+
+    def frame(self, x, y, width, height, pixels, delay=10, disposal=1,
+              transparent=None, interlace=False, palette=None, bits=None):
+        packed = (disposal << 2) | (0 if transparent is None else 1)
+        self.out += b'\x21\xf9\x04' + struct.pack('<BHB', packed, delay, transparent or 0) + b'\x00'
+
+        flags = 0x40 if interlace else 0
+        if palette is not None:
+            flags |= 0x80 | (bits - 1)
+        self.out += b'\x2c' + struct.pack('<HHHHB', x, y, width, height, flags)
+        if palette is not None:
+            self.out += color_table(palette, bits)
+
+        rows = [pixels[r * width:(r + 1) * width] for r in range(height)]
+        if interlace:
+            order = (list(range(0, height, 8)) + list(range(4, height, 8)) +
+                     list(range(2, height, 4)) + list(range(1, height, 2)))
+            rows = [rows[r] for r in order]
+        code_size = max(2, bits or self.bits)
+        self.out.append(code_size)
+        self.out += sub_blocks(lzw_encode([p for row in rows for p in row], code_size))
+
+    def save(self, path):
+        with open(path, 'wb') as f:
+            f.write(self.out + b'\x3b')
+
+
+def random_palette(rnd, count):
+    return [(rnd.randrange(256), rnd.randrange(256), rnd.randrange(256)) for _ in range(count)]
+
+
+def stripes(width, height, colors, phase):
+    return [((x // 4 + y // 4 + phase) % colors) for y in range(height) for x in range(width)]
+
+
+def make_gifs(directory):
+    rnd = random.Random(1234)
+    palette16 = random_palette(rnd, 16)
+    palette256 = random_palette(rnd, 256)
+
+    gif = GifWriter(32, 32, palette16, 4)
+    for t in range(8):
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, t))
+    gif.save(os.path.join(directory, 'BASIC16.GIF'))
+
+    gif = GifWriter(32, 32, palette16, 4)
+    for t in range(8):
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, t), delay=8, interlace=True)
+    gif.save(os.path.join(directory, 'INTERL.GIF'))
+
+    # An 8x8 sprite with a transparent border moving over a background
+    for disposal in (1, 2, 3):
+        gif = GifWriter(32, 32, palette16, 4, background=3, loops=0)
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, 0))
+        for t in range(12):
+            sprite = [0 if (x in (0, 7) or y in (0, 7)) else 5 + (t % 4)
+                      for y in range(8) for x in range(8)]
+            gif.frame((t * 3) % 24, (t * 5) % 24, 8, 8, sprite, delay=6,
+                      disposal=disposal, transparent=0)
+        gif.save(os.path.join(directory, 'SPRITE%d.GIF' % disposal))
+
+    gif = GifWriter(32, 32, palette16, 4)
+    for t in range(6):
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, t), palette=random_palette(rnd, 16), bits=4)
+    gif.save(os.path.join(directory, 'LOCALPAL.GIF'))
+
+    # Runs of frames that are the same as the one before
+    gif = GifWriter(32, 32, palette16, 4, loops=0)
+    for t in range(6):
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, 0))
+    for t in range(5):
+        gif.frame(4, 4, 8, 8, [7] * 64)
+    gif.save(os.path.join(directory, 'HOLD.GIF'))
+
+    gif = GifWriter(32, 32, palette16, 4, loops=2)
+    gif.comment('loop twice')
+    for t in range(4):
+        gif.frame(0, 0, 32, 32, stripes(32, 32, 16, t * 2), delay=5)
+    gif.save(os.path.join(directory, 'LOOP2.GIF'))
+
+    gif = GifWriter(32, 32, palette16, 4)
+    gif.frame(8, 8, 16, 16, stripes(16, 16, 16, 0), interlace=True)
+    for t in range(5):
+        gif.frame(4 + t, 4, 20, 11, stripes(20, 11, 16, t), delay=7, interlace=True, transparent=2)
+    gif.save(os.path.join(directory, 'ODDRECT.GIF'))
+
+    gif = GifWriter(32, 32, palette256, 8)
+    for t in range(6):
+        gif.frame(0, 0, 32, 32, [rnd.randrange(256) for _ in range(1024)])
+    gif.save(os.path.join(directory, 'NOISE256.GIF'))
+
+    gif = GifWriter(32, 32, palette256, 8)
+    for t in range(6):
+        gif.frame(0, 0, 32, 32, [rnd.randrange(256) for _ in range(1024)], interlace=True)
+    gif.save(os.path.join(directory, 'NOISEIL.GIF'))
+
+    # Images larger than the matrix are scaled down by the decoder
+    gif = GifWriter(64, 64, palette16, 4, loops=0)
+    for t in range(6):
+        gif.frame(0, 0, 64, 64, stripes(64, 64, 16, t))
+    gif.save(os.path.join(directory, 'BIG64.GIF'))
+
+    gif = GifWriter(128, 128, palette256, 8, loops=0)
+    for t in range(3):
+        gif.frame(0, 0, 128, 128, [((x + y + t * 9) // 3) % 256 for y in range(128) for x in range(128)])
+    gif.save(os.path.join(directory, 'BIG128.GIF'))
+
+    # Enough noise to fill the string table so the decoder sees clear codes
+    gif = GifWriter(64, 64, palette256, 8)
+    for t in range(2):
+        gif.frame(0, 0, 64, 64, [rnd.randrange(256) for _ in range(4096)])
+    gif.save(os.path.join(directory, 'NOISE64.GIF'))
+
+
+def main(args):
+    if len(args) != 1:
+        print('Usage: makegifs.py <SD card root>')
+        return 1
+
+    directory = os.path.join(args[0], DIRECTORY)
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    make_gifs(directory)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,154 @@
+/*
+ * Animation pack check for the host build
+ * Plays each animation of the pack made by tools/gif2pak.py with the pack
+ * player and then the GIF file it was made from with the GIF decoder, and
+ * compares the frames the two put on the matrix. A frame shown again
+ * unchanged is counted once, as the two players don't hold frames the same
+ * way. Returns 1 if any animation differs
+ *
+ * Usage: packcheck <SD card root> [directory]
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "GifDecoder.h"
+#include "SdFat.h"
+#include "SmartMatrix.h"
+
+// Defined in GIFParseFunctions.cpp
+extern unsigned long processGIFFile(const char *pathname, unsigned long (*checkForInput)(), unsigned long playTime);
+
+// Defined in FrameCacheFunctions.cpp
+extern void frameCacheInit(byte *ram, int size);
+
+// Defined in PackPlayerFunctions.cpp
+extern int packOpen(const char *directoryName);
+extern unsigned long processPackAnimation(int index, unsigned long (*checkForInput)(), unsigned long playTime);
+
+// Defined in LightAppliance.ino on the appliance
+SmartMatrix matrix;
+SdFat sd;
+byte frameCacheRAM[FRAME_CACHE_SIZE];
+
+#define DEFAULT_DIRECTORY "/gengifs/"
+
+// Pack layout, see PackPlayerFunctions.cpp
+#define PACK_HEADER_SIZE 8
+#define PACK_NAME_SIZE   13
+#define PACK_TOC_SIZE    (4 + PACK_NAME_SIZE)
+
+#define FRAME_PIXELS (MATRIX_WIDTH * MATRIX_HEIGHT)
+
+typedef std::vector<rgb24> Frame;
+
+std::vector<Frame> frames;
+
+unsigned long checkForInput() {
+
+    return 0;
+}
+
+boolean sameFrame(const Frame &a, const Frame &b) {
+
+    return memcmp(&a[0], &b[0], FRAME_PIXELS * sizeof(rgb24)) == 0;
+}
+
+void recordFrame(const rgb24 *pixels) {
+
+    Frame frame(pixels, pixels + FRAME_PIXELS);
+    if (frames.empty() || (! sameFrame(frames.back(), frame))) {
+        frames.push_back(frame);
+    }
+}
+
+// Play an animation once from a black screen
+//   pathname the GIF file to play or NULL to play animation index of the pack
+std::vector<Frame> playFrames(const char *pathname, int index) {
+
+    frames.clear();
+    matrix.fillScreen({ 0, 0, 0 });
+    if (pathname) {
+        processGIFFile(pathname, checkForInput, GIF_PLAY_ONCE);
+    }
+    else    {
+        processPackAnimation(index, checkForInput, GIF_PLAY_ONCE);
+    }
+    return frames;
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: packcheck <SD card root> [directory]\n");
+        return 1;
+    }
+    sdSetRoot(argv[1]);
+    if (! sd.begin(0)) {
+        sd.initErrorHalt();
+    }
+    frameCacheInit(frameCacheRAM, sizeof(frameCacheRAM));
+    std::string directoryName = (argc > 2) ? argv[2] : DEFAULT_DIRECTORY;
+    if (directoryName[directoryName.size() - 1] != '/') {
+        directoryName += '/';
+    }
+    Serial.setOutput(NULL);
+    hostShowFrame = recordFrame;
+
+    int count = packOpen(directoryName.c_str());
+    if (count == 0) {
+        fprintf(stderr, "No animation pack for %s, run tools/gif2pak.py first\n", directoryName.c_str());
+        return 1;
+    }
+    // The table of contents names the GIF files
+    SdFile packFile;
+    std::string packPathname = directoryName.substr(0, directoryName.size() - 1) + ".pak";
+    if (! packFile.open(packPathname.c_str())) {
+        sd.errorHalt("Could not open the pack");
+    }
+
+    int failures = 0;
+    for (int index = 0; index < count; index++) {
+        char name[PACK_NAME_SIZE];
+        packFile.seekSet(PACK_HEADER_SIZE + (index * PACK_TOC_SIZE) + 4);
+        packFile.read(name, PACK_NAME_SIZE);
+        name[PACK_NAME_SIZE - 1] = '\0';
+        std::string pathname = directoryName + name;
+
+        std::vector<Frame> packFrames = playFrames(NULL, index);
+        std::vector<Frame> gifFrames = playFrames(pathname.c_str(), 0);
+
+        size_t frame = 0;
+        while ((frame < packFrames.size()) && (frame < gifFrames.size()) &&
+               sameFrame(packFrames[frame], gifFrames[frame])) {
+            frame++;
+        }
+        printf("%-12s %4d pack frames %4d GIF frames  ",
+               name, (int) packFrames.size(), (int) gifFrames.size());
+        if ((frame == packFrames.size()) && (frame == gifFrames.size())) {
+            printf("same\n");
+        }
+        else    {
+            printf("differ from frame %d\n", (int) frame);
+            failures++;
+        }
+    }
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+/*
+ * Host stand-in for the Arduino core
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Arduino.h"
+
+
+HardwareSerial Serial;
+Teensy3ClockClass Teensy3Clock;
+
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// Time added by delay()
+static unsigned long delayedMicros;
+
+unsigned long micros() {
+
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - startTime;
+    return (unsigned long) std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + delayedMicros;
+}
+
+unsigned long millis() {
+
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+
+    delayedMicros += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+
+    delayedMicros += us;
+}
+
+long random(long howbig) {
+
+    return (howbig > 0) ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+
+    return (howsmall < howbig) ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+
+    srand(seed);
+}
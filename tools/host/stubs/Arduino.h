@@ -0,0 +1,136 @@
+/*
+ * Host stand-in for the Arduino core
+ * Lets the sketch sources be built and run on a computer by tools/host
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+// Standard headers the stand-ins use are included before the Arduino macros
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+#define DEC     10
+#define HEX     16
+#define A14     14
+
+#define PI 3.1415926535897932384626433832795
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Time runs from the start of the program. delay() doesn't sleep but moves
+// the clock on, so frames are paced as on the board without waiting
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+inline void pinMode(uint8_t pin, uint8_t mode) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) {}
+inline int digitalRead(uint8_t pin) { return LOW; }
+inline int analogRead(uint8_t pin) { return 0; }
+
+class String {
+public:
+    String() {}
+    String(const char *s) : str(s) {}
+    void concat(char c) { str += c; }
+    void toCharArray(char *buf, unsigned int size) {
+        strncpy(buf, str.c_str(), size);
+        buf[size - 1] = '\0';
+    }
+    std::string str;
+};
+
+// Output goes to the stream given to setOutput(), stdout unless changed.
+// A NULL stream drops the output
+class Print {
+public:
+    Print() : out(stdout) {}
+    void setOutput(FILE *stream) { out = stream; }
+
+    void print(const char *s) { if (out) fputs(s, out); }
+    void print(char c) { if (out) fputc(c, out); }
+    void print(const String &s) { print(s.str.c_str()); }
+    void print(unsigned char n, int base = DEC) { print((unsigned long) n, base); }
+    void print(int n, int base = DEC) { print((long) n, base); }
+    void print(unsigned int n, int base = DEC) { print((unsigned long) n, base); }
+    void print(long n, int base = DEC) {
+        if (base == DEC) {
+            if (out) fprintf(out, "%ld", n);
+        }
+        else    {
+            print((unsigned long) n, base);
+        }
+    }
+    void print(unsigned long n, int base = DEC) { if (out) fprintf(out, (base == HEX) ? "%lX" : "%lu", n); }
+    void print(double n, int digits = 2) { if (out) fprintf(out, "%.*f", digits, n); }
+
+    template<class T> void println(T value) { print(value); println(); }
+    template<class T> void println(T value, int format) { print(value, format); println(); }
+    void println() { print('\n'); }
+
+private:
+    FILE *out;
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(long baud) {}
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+class Teensy3ClockClass {
+public:
+    unsigned long get() { return 0; }
+    void set(unsigned long t) {}
+};
+
+extern Teensy3ClockClass Teensy3Clock;
+
+#endif
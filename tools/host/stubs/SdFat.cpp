@@ -0,0 +1,371 @@
+/*
+ * Host stand-in for the SdFat library
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SdFat.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BLOCK_SIZE  512
+
+static std::string sdRoot = ".";
+
+// Cluster numbers handed out to files in the order they are first seen
+static std::map<std::string, uint32_t> clusters;
+static uint32_t nextCluster = 2;
+
+// Block ranges handed out by contiguousRange(), which never overlap
+struct BlockRange {
+    uint32_t first;
+    uint32_t count;
+};
+static std::map<std::string, BlockRange> ranges;
+static std::map<uint32_t, std::string> rangeFiles;
+static uint32_t nextBlock = 1024;
+
+void sdSetRoot(const char *path) {
+
+    sdRoot = path;
+    while ((sdRoot.size() > 1) && (sdRoot[sdRoot.size() - 1] == '/')) {
+        sdRoot.erase(sdRoot.size() - 1);
+    }
+}
+
+static std::string hostPathname(const char *path) {
+
+    std::string pathname = sdRoot;
+    if (path[0] != '/') {
+        pathname += '/';
+    }
+    pathname += path;
+    while ((pathname.size() > 1) && (pathname[pathname.size() - 1] == '/')) {
+        pathname.erase(pathname.size() - 1);
+    }
+    return pathname;
+}
+
+static uint32_t clusterOf(const std::string &hostPath) {
+
+    std::map<std::string, uint32_t>::iterator it = clusters.find(hostPath);
+    if (it != clusters.end()) {
+        return it->second;
+    }
+    clusters[hostPath] = nextCluster;
+    return nextCluster++;
+}
+
+// Fill in a directory entry the way FAT would store it
+static bool makeEntry(const std::string &hostPath, dir_t *dir) {
+
+    struct stat st;
+    if (stat(hostPath.c_str(), &st) != 0) {
+        return false;
+    }
+    memset(dir, 0, sizeof(dir_t));
+    memset(dir->name, ' ', sizeof(dir->name));
+
+    std::string name = hostPath.substr(hostPath.rfind('/') + 1);
+    size_t dot = name.rfind('.');
+    std::string base = (dot == std::string::npos) ? name : name.substr(0, dot);
+    std::string ext = (dot == std::string::npos) ? "" : name.substr(dot + 1);
+    for (size_t i = 0; (i < base.size()) && (i < 8); i++) {
+        dir->name[i] = toupper(base[i]);
+    }
+    for (size_t i = 0; (i < ext.size()) && (i < 3); i++) {
+        dir->name[8 + i] = toupper(ext[i]);
+    }
+
+    struct tm *t = localtime(&st.st_mtime);
+    dir->lastWriteDate = ((t->tm_year - 80) << 9) | ((t->tm_mon + 1) << 5) | t->tm_mday;
+    dir->lastWriteTime = (t->tm_hour << 11) | (t->tm_min << 5) | (t->tm_sec / 2);
+
+    uint32_t cluster = clusterOf(hostPath);
+    dir->firstClusterHigh = cluster >> 16;
+    dir->firstClusterLow = cluster & 0xFFFF;
+    if (S_ISDIR(st.st_mode)) {
+        dir->attributes = DIR_ATT_DIRECTORY;
+    }
+    else    {
+        dir->attributes = DIR_ATT_ARCHIVE;
+        dir->fileSize = st.st_size;
+    }
+    return true;
+}
+
+SdBaseFile::SdBaseFile() : fp(NULL), dir(false), position(0), nextName(0) {
+}
+
+SdBaseFile::SdBaseFile(const SdBaseFile &from) : fp(NULL), dir(false), position(0), nextName(0) {
+    *this = from;
+}
+
+SdBaseFile::~SdBaseFile() {
+    close();
+}
+
+// A copy is a second handle on the same file
+SdBaseFile &SdBaseFile::operator=(const SdBaseFile &from) {
+
+    if (this != &from) {
+        close();
+        hostPath = from.hostPath;
+        dir = from.dir;
+        position = from.position;
+        names = from.names;
+        nextName = from.nextName;
+        if (from.fp) {
+            fflush(from.fp);
+            fp = fopen(hostPath.c_str(), "r+b");
+        }
+    }
+    return *this;
+}
+
+bool SdBaseFile::open(const char *path, uint8_t oflag) {
+
+    close();
+    hostPath = hostPathname(path);
+
+    struct stat st;
+    boolean exists = stat(hostPath.c_str(), &st) == 0;
+    if (exists && S_ISDIR(st.st_mode)) {
+        DIR *d = opendir(hostPath.c_str());
+        if (! d) {
+            return false;
+        }
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL) {
+            if (e->d_name[0] != '.') {
+                names.push_back(e->d_name);
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        dir = true;
+        return true;
+    }
+
+    const char *mode = "rb";
+    if (oflag & O_WRITE) {
+        if ((oflag & O_TRUNC) || (! exists)) {
+            if (! (oflag & O_CREAT) && ! exists) {
+                return false;
+            }
+            mode = "w+b";
+        }
+        else    {
+            mode = "r+b";
+        }
+    }
+    fp = fopen(hostPath.c_str(), mode);
+    return fp != NULL;
+}
+
+bool SdBaseFile::close() {
+
+    if (fp) {
+        fclose(fp);
+    }
+    fp = NULL;
+    dir = false;
+    position = 0;
+    names.clear();
+    nextName = 0;
+    return true;
+}
+
+int16_t SdBaseFile::read() {
+
+    uint8_t b;
+    return (read(&b, 1) == 1) ? b : -1;
+}
+
+int SdBaseFile::read(void *buf, size_t nbyte) {
+
+    if (! fp) {
+        return -1;
+    }
+    fseek(fp, position, SEEK_SET);
+    size_t count = fread(buf, 1, nbyte, fp);
+    position += count;
+    return count;
+}
+
+int SdBaseFile::write(const void *buf, size_t nbyte) {
+
+    if (! fp) {
+        return -1;
+    }
+    fseek(fp, position, SEEK_SET);
+    size_t count = fwrite(buf, 1, nbyte, fp);
+    position += count;
+    return count;
+}
+
+bool SdBaseFile::seekSet(uint32_t pos) {
+
+    if ((! fp) || (pos > fileSize())) {
+        return false;
+    }
+    position = pos;
+    return true;
+}
+
+void SdBaseFile::rewind() {
+
+    position = 0;
+    nextName = 0;
+}
+
+uint32_t SdBaseFile::fileSize() const {
+
+    if (! fp) {
+        return 0;
+    }
+    fflush(fp);
+    struct stat st;
+    return (fstat(fileno(fp), &st) == 0) ? st.st_size : 0;
+}
+
+uint32_t SdBaseFile::firstCluster() const {
+
+    return isOpen() ? clusterOf(hostPath) : 0;
+}
+
+bool SdBaseFile::sync() {
+
+    return (fp == NULL) || (fflush(fp) == 0);
+}
+
+bool SdBaseFile::remove() {
+
+    if (! fp) {
+        return false;
+    }
+    std::string pathname = hostPath;
+    close();
+    return unlink(pathname.c_str()) == 0;
+}
+
+bool SdBaseFile::dirEntry(dir_t *dir) {
+
+    if (! isOpen()) {
+        return false;
+    }
+    sync();
+    return makeEntry(hostPath, dir);
+}
+
+int8_t SdBaseFile::readDir(dir_t *dir) {
+
+    if (! isDir()) {
+        return -1;
+    }
+    while (nextName < names.size()) {
+        if (makeEntry(hostPath + "/" + names[nextName++], dir)) {
+            return sizeof(dir_t);
+        }
+    }
+    return 0;
+}
+
+void SdBaseFile::dirName(const dir_t &dir, char *name) {
+
+    int j = 0;
+    for (int i = 0; i < 11; i++) {
+        if (dir.name[i] == ' ') {
+            continue;
+        }
+        if (i == 8) {
+            name[j++] = '.';
+        }
+        name[j++] = dir.name[i];
+    }
+    name[j] = '\0';
+}
+
+// The blocks of a file stay put until it grows past them
+bool SdBaseFile::contiguousRange(uint32_t *bgnBlock, uint32_t *endBlock) {
+
+    if (! fp) {
+        return false;
+    }
+    uint32_t count = (fileSize() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::map<std::string, BlockRange>::iterator it = ranges.find(hostPath);
+    if ((it == ranges.end()) || (it->second.count < count)) {
+        BlockRange range = { nextBlock, count };
+        ranges[hostPath] = range;
+        rangeFiles[nextBlock] = hostPath;
+        nextBlock += count + 1;
+        it = ranges.find(hostPath);
+    }
+    *bgnBlock = it->second.first;
+    *endBlock = it->second.first + count - 1;
+    return true;
+}
+
+bool Sd2Card::readBlock(uint32_t block, uint8_t *dst) {
+
+    std::map<uint32_t, std::string>::iterator it = rangeFiles.upper_bound(block);
+    if (it == rangeFiles.begin()) {
+        return false;
+    }
+    --it;
+    BlockRange &range = ranges[it->second];
+    if ((range.first != it->first) || (block >= range.first + range.count)) {
+        return false;
+    }
+    FILE *f = fopen(it->second.c_str(), "rb");
+    if (! f) {
+        return false;
+    }
+    memset(dst, 0, BLOCK_SIZE);
+    fseek(f, (long) (block - range.first) * BLOCK_SIZE, SEEK_SET);
+    fread(dst, 1, BLOCK_SIZE, f);
+    fclose(f);
+    return true;
+}
+
+bool SdFat::begin(uint8_t chipSelectPin, uint8_t sckRateID) {
+
+    struct stat st;
+    return (stat(sdRoot.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+}
+
+bool SdFat::mkdir(const char *path, bool pFlag) {
+
+    return ::mkdir(hostPathname(path).c_str(), 0755) == 0;
+}
+
+void SdFat::errorHalt(const char *msg) {
+
+    fprintf(stderr, "error: %s\n", msg);
+    exit(1);
+}
+
+void SdFat::initErrorHalt() {
+
+    errorHalt("card initialization failed");
+}
@@ -0,0 +1,134 @@
+/*
+ * Host stand-in for the SdFat library
+ * The card is a directory on the computer set with sdSetRoot(). Only the
+ * calls the sketch makes are provided. Directory entries get 8.3 names made
+ * from the host names, so the files under the root should have 8.3 names
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SdFat_h
+#define SdFat_h
+
+#include "Arduino.h"
+
+#define O_READ      0x01
+#define O_WRITE     0x02
+#define O_RDWR      (O_READ | O_WRITE)
+#define O_CREAT     0x10
+#define O_TRUNC     0x40
+
+#define SPI_FULL_SPEED  0
+#define SPI_HALF_SPEED  1
+
+#define DIR_ATT_DIRECTORY   0x10
+#define DIR_ATT_ARCHIVE     0x20
+
+// FAT directory entry
+typedef struct dir_t {
+    uint8_t name[11];
+    uint8_t attributes;
+    uint8_t reservedNT;
+    uint8_t creationTimeTenths;
+    uint16_t creationTime;
+    uint16_t creationDate;
+    uint16_t lastAccessDate;
+    uint16_t firstClusterHigh;
+    uint16_t lastWriteTime;
+    uint16_t lastWriteDate;
+    uint16_t firstClusterLow;
+    uint32_t fileSize;
+} dir_t;
+
+static inline uint8_t DIR_IS_FILE(const dir_t *dir) {
+    return (dir->attributes & DIR_ATT_DIRECTORY) == 0;
+}
+
+static inline uint8_t DIR_IS_SUBDIR(const dir_t *dir) {
+    return (dir->attributes & DIR_ATT_DIRECTORY) != 0;
+}
+
+// Set the host directory that stands in for the root of the card
+void sdSetRoot(const char *path);
+
+class SdBaseFile {
+public:
+    SdBaseFile();
+    SdBaseFile(const SdBaseFile &from);
+    virtual ~SdBaseFile();
+    SdBaseFile &operator=(const SdBaseFile &from);
+
+    bool open(const char *path, uint8_t oflag = O_READ);
+    bool close();
+    bool isOpen() const { return isFile() || isDir(); }
+    bool isFile() const { return fp != NULL; }
+    bool isDir() const { return dir; }
+
+    int16_t read();
+    int read(void *buf, size_t nbyte);
+    int write(const void *buf, size_t nbyte);
+    int write(uint8_t b) { return write(&b, 1); }
+    bool seekSet(uint32_t pos);
+    bool seekCur(int32_t offset) { return seekSet(position + offset); }
+    void rewind();
+    uint32_t curPosition() const { return position; }
+    uint32_t fileSize() const;
+    uint32_t firstCluster() const;
+    bool sync();
+    bool remove();
+
+    bool dirEntry(dir_t *dir);
+    int8_t readDir(dir_t *dir);
+    static void dirName(const dir_t &dir, char *name);
+    bool contiguousRange(uint32_t *bgnBlock, uint32_t *endBlock);
+
+private:
+    std::string hostPath;
+    FILE *fp;
+    bool dir;
+    uint32_t position;
+    std::vector<std::string> names;
+    size_t nextName;
+};
+
+class SdFile : public SdBaseFile {
+public:
+    SdFile() {}
+};
+
+class Sd2Card {
+public:
+    bool readBlock(uint32_t block, uint8_t *dst);
+};
+
+class SdFat {
+public:
+    bool begin(uint8_t chipSelectPin, uint8_t sckRateID = SPI_FULL_SPEED);
+    Sd2Card *card() { return &sdCard; }
+    bool mkdir(const char *path, bool pFlag = true);
+    void errorHalt(const char *msg);
+    void initErrorHalt();
+
+private:
+    Sd2Card sdCard;
+};
+
+#endif
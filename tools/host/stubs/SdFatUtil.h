@@ -0,0 +1 @@
+// Host stand-in for the SdFat utilities, none of which the sketch uses
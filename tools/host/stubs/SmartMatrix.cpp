@@ -0,0 +1,64 @@
+/*
+ * Host stand-in for the SmartMatrix library
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SmartMatrix.h"
+
+void (*hostShowFrame)(const rgb24 *frame);
+
+void SmartMatrix::swapBuffers(bool copy) {
+
+    if (hostShowFrame) {
+        hostShowFrame(&frame[0][0]);
+    }
+}
+
+void SmartMatrix::drawPixel(int16_t x, int16_t y, rgb24 color) {
+
+    if ((x >= 0) && (x < MATRIX_WIDTH) && (y >= 0) && (y < MATRIX_HEIGHT)) {
+        frame[y][x] = color;
+    }
+}
+
+rgb24 SmartMatrix::readPixel(int16_t x, int16_t y) {
+
+    rgb24 black = { 0, 0, 0 };
+    if ((x >= 0) && (x < MATRIX_WIDTH) && (y >= 0) && (y < MATRIX_HEIGHT)) {
+        return frame[y][x];
+    }
+    return black;
+}
+
+void SmartMatrix::fillScreen(rgb24 color) {
+
+    fillRectangle(0, 0, MATRIX_WIDTH - 1, MATRIX_HEIGHT - 1, color);
+}
+
+void SmartMatrix::fillRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 color) {
+
+    for (int y = min(y0, y1); y <= max(y0, y1); y++) {
+        for (int x = min(x0, x1); x <= max(x0, x1); x++) {
+            drawPixel(x, y, color);
+        }
+    }
+}
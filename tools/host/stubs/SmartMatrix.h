@@ -0,0 +1,114 @@
+/*
+ * Host stand-in for the SmartMatrix library
+ * There is one frame buffer, which is both the back buffer that is drawn
+ * into and the frame that swapBuffers() shows. Only the drawing functions
+ * the GIF and pack players use draw anything
+ *
+ * Written by: Craig A. Lindley
+ * Copyright (c) 2014 Craig A. Lindley
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SmartMatrix_h
+#define SmartMatrix_h
+
+#include "Arduino.h"
+
+#define MATRIX_WIDTH    32
+#define MATRIX_HEIGHT   32
+
+typedef struct rgb24 {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+} rgb24;
+
+#define RGB24_ISEQUAL(a, b) ((a.red == b.red) && (a.green == b.green) && (a.blue == b.blue))
+
+typedef enum ScrollMode {
+    wrapForward, bounceForward, bounceReverse, stopped, off
+} ScrollMode;
+
+typedef enum fontChoices {
+    font3x5, font5x7, font6x10, font8x13
+} fontChoices;
+
+typedef enum colorCorrectionModes {
+    ccNone, cc24, cc12
+} colorCorrectionModes;
+
+class SmartMatrix;
+
+// Called by swapBuffers() with the frame being shown, if set
+extern void (*hostShowFrame)(const rgb24 *frame);
+
+class SmartMatrix {
+public:
+    void begin() {}
+    void swapBuffers(bool copy = true);
+    rgb24 *backBuffer() { return &frame[0][0]; }
+
+    void drawPixel(int16_t x, int16_t y, rgb24 color);
+    rgb24 readPixel(int16_t x, int16_t y);
+    void fillScreen(rgb24 color);
+    void fillRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 color);
+    void fillRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 outlineColor, rgb24 fillColor) {
+        fillRectangle(x0, y0, x1, y1, fillColor);
+    }
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 color) {}
+    void drawFastVLine(int16_t x, int16_t y0, int16_t y1, rgb24 color) {}
+    void drawFastHLine(int16_t x0, int16_t x1, int16_t y, rgb24 color) {}
+    void drawCircle(int16_t x0, int16_t y0, uint16_t radius, rgb24 color) {}
+    void fillCircle(int16_t x0, int16_t y0, uint16_t radius, rgb24 color) {}
+    void fillCircle(int16_t x0, int16_t y0, uint16_t radius, rgb24 outlineColor, rgb24 fillColor) {}
+    void drawTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t x3, int16_t y3, rgb24 color) {}
+    void fillTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t x3, int16_t y3, rgb24 color) {}
+    void fillTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t x3, int16_t y3,
+                      rgb24 outlineColor, rgb24 fillColor) {}
+    void drawRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, rgb24 color) {}
+    void drawRoundRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t radius, rgb24 color) {}
+    void fillRoundRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t radius, rgb24 color) {}
+    void fillRoundRectangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t radius,
+                            rgb24 outlineColor, rgb24 fillColor) {}
+    void drawChar(int16_t x, int16_t y, rgb24 charColor, char character) {}
+    void drawString(int16_t x, int16_t y, rgb24 charColor, const char text[]) {}
+    void drawString(int16_t x, int16_t y, rgb24 charColor, rgb24 backColor, const char text[]) {}
+    void drawMonoBitmap(int16_t x, int16_t y, uint8_t width, uint8_t height, rgb24 bitmapColor, uint8_t *bitmap) {}
+
+    void scrollText(const char inputtext[], int numScrolls) {}
+    void setScrollMode(ScrollMode mode) {}
+    void setScrollSpeed(unsigned char pixels_per_second) {}
+    void setScrollFont(fontChoices newFont) {}
+    void setScrollColor(rgb24 newColor) {}
+    void setScrollOffsetFromEdge(int offset) {}
+    void stopScrollText() {}
+    int getScrollStatus() { return 0; }
+
+    uint16_t getScreenWidth() { return MATRIX_WIDTH; }
+    uint16_t getScreenHeight() { return MATRIX_HEIGHT; }
+    void setBrightness(uint8_t brightness) {}
+    void setColorCorrection(colorCorrectionModes mode) {}
+    void setFont(fontChoices newFont) {}
+
+private:
+    rgb24 frame[MATRIX_HEIGHT][MATRIX_WIDTH];
+};
+
+#endif
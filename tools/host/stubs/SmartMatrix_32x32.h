@@ -0,0 +1,2 @@
+// Host stand-in for the SmartMatrix library, see SmartMatrix.h
+#include "SmartMatrix.h"